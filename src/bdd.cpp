@@ -11,7 +11,15 @@
 // Contact ohad@idni.org for requesting a permission. This license may be
 // modified over time by the Author.
 #include <cassert>
+#include <cstring>
 #include <algorithm>
+#include <chrono>
+#ifdef WITH_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#endif
 #include "bdd.h"
 
 #ifndef NOOUTPUTS
@@ -41,19 +49,38 @@ template<typename T1, typename T2> struct vec2cmp {
 	}
 };
 
-// Maps a BDD definition its unique ID
-unordered_map<bdd_key, bdd_id> id_map;
 // Maps a BDD ID to its (unique) definition
 bdd_mmap V;
+// Maps a BDD definition its unique ID
+unique_table<bdd_mmap> id_map(V);
 // Controls whether or not garbage collection is enabled
 bool gc_enabled = true;
+// Selects how garbage collection is done
+gc_mode bdd_gc_mode = GC_COMPACT;
+// Reference counts of the nodes in GC_REFCOUNT mode. A count covers the parents
+// of the node in V and the handles referencing it. Freed nodes are marked with
+// freed_ref and defined as (0,0) until their ids are reused.
+vector<uint32_t> refs;
+const uint32_t freed_ref = uint32_t(-1);
+// Nodes whose reference count dropped to zero, to be freed by the next gc
+vector<bdd_id> dead;
+// Ids of freed nodes reused by bdd::add
+vector<bdd_id> free_ids;
+// Number of collections, nodes freed by the last one and pause times in ms
+size_t gc_runs = 0, gc_freed = 0;
+double gc_pause_total = 0, gc_pause_max = 0;
+function<void(chrono::steady_clock::time_point, double)> bdd_gc_hook;
+// Number of nodes created and of lookups in the memos, for profiling
+size_t nodes_added = 0, memo_hits = 0, memo_misses = 0;
 #ifndef NOMMAP
 size_t max_bdd_nodes = 0;
 mmap_mode bdd_mmap_mode = MMAP_NONE;
 string bdd_mmap_file = "";
 #endif
 // Maps a BDD triple (a,b,c) to the BDD corresponding to (a&b)|(~a&c)
-unordered_map<ite_memo, bdd_ref> C;
+ite_cache C;
+// Size of the ite/and computed table in bytes
+size_t ite_cache_bytes = 1 << 24;
 // Maps a BDD pair (a,b) and variable list c to the BDD exists c (a&b)
 map<bools, unordered_map<array<bdd_ref, 2>, bdd_ref>, veccmp<bool>> CX;
 // Maps a BDD pair (a,b), variable list c, and permutation list d to the BDD
@@ -68,7 +95,7 @@ map<bools, unordered_map<bdds, bdd_ref>, veccmp<bool>> AMX;
 // exists b (a_0 & ... & a_N) with the variables renamed according c
 map<pair<bools, bdd_shfts>, unordered_map<bdds, bdd_ref>, vec2cmp<bool, bdd_shft>> AMXP;
 // Used to store the marked set in the mark-and-sweep garbage collector
-unordered_set<bdd_id> S;
+bdd_marks S;
 // Maps a live BDD to the handle that keeps it alive
 unordered_map<bdd_ref, weak_ptr<bdd_handle>> bdd_handle::M;
 spbdd_handle htrue, hfalse;
@@ -93,33 +120,269 @@ _Pragma("GCC diagnostic pop")
 
 size_t gclimit = 1e+7;
 
+// Variable order. Callers name variables by their logical index, nodes branch
+// on physical levels. var_level maps a logical variable to its level and
+// level_var is its inverse; both are empty while the order is the identity and
+// variables beyond their size keep their own index as level.
+bdd_shfts var_level, level_var;
+// Number of live nodes that triggers reordering from gc, 0 disables it
+size_t reorder_limit = 0;
+// Number of reorderings, live nodes before and after the last one and its time
+size_t reorder_runs = 0, reorder_before = 0, reorder_after = 0;
+double reorder_time = 0;
+bool reordering = false;
+// A swap rebuilds everything above the swapped levels, so a reordering sifts at
+// most reorder_max_vars variables and does at most reorder_max_swaps swaps
+const size_t reorder_max_vars = 32, reorder_max_swaps = 1024;
+size_t reorder_swaps;
+
+inline bdd_shft level(bdd_shft v) {
+	return v < var_level.size() ? var_level[v] : v;
+}
+/* Translate a logical variable list to physical levels. */
+bools levels(const bools& ex) {
+	if (var_level.empty()) return ex;
+	bools r(max(ex.size(), var_level.size()));
+	for (size_t n = 0; n != ex.size(); ++n) r[level(n)] = ex[n];
+	return r;
+}
+/* Translate a logical renaming to a renaming of physical levels. */
+bdd_shfts levels(const bdd_shfts& p) {
+	if (var_level.empty()) return p;
+	bdd_shfts r(max(p.size(), var_level.size()));
+	for (size_t n = 0; n != r.size(); ++n) r[n] = n;
+	for (size_t n = 0; n != p.size(); ++n) r[level(n)] = level(p[n]);
+	return r;
+}
+
+inline void incref(bdd_ref x) { if (GET_BDD_ID(x) > 1) ++refs[GET_BDD_ID(x)]; }
+inline void decref(bdd_ref x) {
+	if (GET_BDD_ID(x) > 1 && !--refs[GET_BDD_ID(x)])
+		dead.push_back(GET_BDD_ID(x));
+}
+inline bool freed(bdd_ref x) { return refs[GET_BDD_ID(x)] == freed_ref; }
+template <size_t N> bool freed(const array<bdd_ref, N>& x) {
+	for (bdd_ref i : x) if (freed(i)) return true;
+	return false;
+}
+bool freed(const bdds& x) {
+	for (bdd_ref i : x) if (freed(i)) return true;
+	return false;
+}
+
+/* Decides whether the top level operations should collect garbage before they
+ * start. In GC_REFCOUNT mode it is the amount of garbage candidates that
+ * matters as collection time is proportional to it. */
+inline bool gc_due() {
+	return bdd_gc_mode == GC_REFCOUNT ? dead.size() >= gclimit
+		: V.size() >= gclimit;
+}
+
+/* Stores the node (h,l) under a fresh or a reused id. */
+inline bdd_id new_node(bdd_ref h, bdd_ref l) {
+	bdd_id id;
+	if (free_ids.empty()) V.emplace_back(h, l), id = V.size() - 1;
+	else id = free_ids.back(), free_ids.pop_back(), V[id] = bdd(h, l);
+	++nodes_added;
+	if (bdd_gc_mode == GC_REFCOUNT) {
+		if (refs.size() < V.size()) refs.resize(V.size());
+		refs[id] = 0, incref(h), incref(l), dead.push_back(id);
+	}
+	return id;
+}
+
+#ifdef WITH_THREADS
+/* Parallel apply. While a top level operation runs with more than one thread,
+ * the first levels of its recursion fork one of their two independent
+ * subproblems into a task queue served by a pool of workers. A thread joining a
+ * forked task runs it itself if no worker took it yet, otherwise it helps with
+ * other queued tasks until the task is done. V and id_map are read without
+ * locking: a new node is appended to V under add_mutex and then published by a
+ * release store into its slot of id_map. C is shared through its striped locks
+ * and the memo maps through memo_mutex. As V and id_map cannot move while other
+ * threads read them, growing them stops the world: the growing thread waits
+ * until every other busy thread is parked in bdd::add or waits for a task. */
+
+struct bdd_task {
+	function<void()> f;
+	size_t spawn;
+	enum { QUEUED, TAKEN, DONE } state;
+};
+
+// Set while a parallel section runs
+bool par = false;
+// Number of recursion levels the current thread may still fork
+thread_local size_t spawn = 0;
+// Serialize node creation and the memo maps during a parallel section
+mutex add_mutex, memo_mutex;
+
+class bdd_pool {
+public:
+	explicit bdd_pool(size_t n) : levels(msb(n) + 3) {
+		for (size_t i = 1; i < n; ++i) w.emplace_back([this] { work(); });
+	}
+	~bdd_pool() {
+		{ lock_guard<mutex> l(m); stop = true; }
+		cv.notify_all();
+		for (thread& t : w) t.join();
+	}
+	// Number of recursion levels forked by a parallel section
+	const size_t levels;
+	void begin() { lock_guard<mutex> l(m); busy = 1; }
+	template <typename A, typename B>
+	void fork(bdd_ref& ra, A& a, bdd_ref& rb, B& b) {
+		bdd_task t{ [&ra, &a] { ra = a(); }, spawn - 1, bdd_task::QUEUED };
+		{ lock_guard<mutex> l(m); q.push_back(&t); }
+		cv.notify_one();
+		const size_t s = spawn;
+		spawn = s - 1, rb = b(), spawn = s;
+		join(t);
+	}
+	// Parks the calling thread while another one grows V and id_map.
+	void safe_point() {
+		if (!growing.load(memory_order_acquire)) return;
+		unique_lock<mutex> l(m);
+		if (growing) park(l);
+	}
+	// Calls f once every other busy thread is parked.
+	template <typename F> void grow(F f) {
+		unique_lock<mutex> l(m);
+		if (growing) return park(l);
+		growing = true, cv.wait(l, [this] { return busy == 1; }), f();
+		growing = false, cv.notify_all();
+	}
+private:
+	vector<thread> w;
+	deque<bdd_task*> q;
+	mutex m;
+	condition_variable cv;
+	atomic<bool> growing{false};
+	size_t busy = 0;
+	bool stop = false;
+	static void run(bdd_task& t) {
+		const size_t s = spawn;
+		spawn = t.spawn, t.f(), spawn = s;
+	}
+	void park(unique_lock<mutex>& l) {
+		--busy, cv.notify_all();
+		cv.wait(l, [this] { return !growing; }), ++busy;
+	}
+	void join(bdd_task& t) {
+		unique_lock<mutex> l(m);
+		for (bdd_task* o;;) {
+			if (t.state == bdd_task::DONE) return;
+			if (t.state == bdd_task::QUEUED) {
+				q.erase(find(q.begin(), q.end(), &t));
+				return l.unlock(), run(t);
+			}
+			if (!q.empty() && !growing) {
+				o = q.back(), q.pop_back(), o->state = bdd_task::TAKEN;
+				l.unlock(), run(*o), l.lock();
+				o->state = bdd_task::DONE, cv.notify_all();
+				continue;
+			}
+			--busy, cv.notify_all();
+			cv.wait(l, [&] { return !growing &&
+				(t.state == bdd_task::DONE || !q.empty()); });
+			++busy;
+		}
+	}
+	void work() {
+		unique_lock<mutex> l(m);
+		for (bdd_task* t;;) {
+			cv.wait(l, [this] { return stop || (!q.empty() && !growing); });
+			if (stop) return;
+			t = q.front(), q.pop_front(), t->state = bdd_task::TAKEN, ++busy;
+			l.unlock(), run(*t), l.lock();
+			t->state = bdd_task::DONE, --busy, cv.notify_all();
+		}
+	}
+};
+
+unique_ptr<bdd_pool> pool;
+
+inline bool room() { return V.size() < V.capacity() && id_map.room(); }
+inline void reserve_nodes(size_t n) { V.reserve(n), id_map.reserve(n); }
+
+/* bdd::add during a parallel section: a lock-free lookup, falling back to
+ * inserting under add_mutex. */
+bdd_id add_par(bdd_ref h, bdd_ref l) {
+	for (;;) {
+		pool->safe_point();
+		if (const bdd_id id = id_map.find(h, l)) return id;
+		{
+			lock_guard<mutex> lk(add_mutex);
+			if (room()) {
+				bdd_id& id = id_map.at(h, l);
+				if (!id) __atomic_store_n(&id, new_node(h, l),
+					__ATOMIC_RELEASE), id_map.added();
+				return id;
+			}
+		}
+		pool->grow([] { if (!room()) reserve_nodes(V.capacity() << 1); });
+	}
+}
+
+/* Runs the top level operation in its scope in parallel if there is a pool. */
+struct par_section {
+	const bool on;
+	par_section() : on(pool && !par) {
+		if (!on) return;
+		if (V.capacity() - V.size() < (V.size() >> 2) + 1024)
+			reserve_nodes((V.size() << 1) + 1024);
+		id_map.reserve(V.capacity());
+		pool->begin(), C.shared = par = true, spawn = pool->levels;
+	}
+	~par_section() { if (on) C.shared = par = false, spawn = 0; }
+};
+
+// Holds memo_mutex for the rest of the scope during a parallel section
+#define MEMO_LOCK unique_lock<mutex> memo_lock(memo_mutex, defer_lock); \
+	if (par) memo_lock.lock()
+#else
+struct par_section { par_section() {} };
+#define MEMO_LOCK
+#endif
+
+/* Evaluates ra = a() and rb = b(), in parallel if the current thread may fork. */
+template <typename A, typename B>
+inline void fork2(bdd_ref& ra, A a, bdd_ref& rb, B b) {
+#ifdef WITH_THREADS
+	if (spawn) return pool->fork(ra, a, rb, b);
+#endif
+	ra = a(), rb = b();
+}
+
+template <typename M, typename K> bool memo_find(M& m, const K& k, bdd_ref& r) {
+	MEMO_LOCK;
+	auto it = m.find(k);
+	if (it == m.end()) return ++memo_misses, false;
+	return r = it->second, ++memo_hits, true;
+}
+
+template <typename M, typename K> bdd_ref memo_put(M& m, K&& k, bdd_ref r) {
+	MEMO_LOCK;
+	return m.emplace(forward<K>(k), r).first->second;
+}
+
 #ifndef NOMMAP
-void bdd::init(mmap_mode m, size_t max_size, const string fn) {
+void bdd::init(mmap_mode m, size_t max_size, const string fn, bool huge) {
 	bdd_mmap_mode = m;
 	if ((max_bdd_nodes = max_size / sizeof(bdd)) < 2) max_bdd_nodes = 2;
-	V = bdd_mmap(memory_map_allocator<bdd>(fn, m));
+	// The map starts at max_size and grows with V. Nodes are referred to
+	// by their ids, so moving them into a larger map invalidates nothing.
+	V = bdd_mmap(memory_map_allocator<bdd>(fn, m,
+		MMAP_RANDOM | (huge ? MMAP_HUGE : MMAP_NORMAL)));
 	if (m != MMAP_NONE) V.reserve(max_bdd_nodes);
 #else
 void bdd::init() {
 #endif
-	S.insert(0), S.insert(1), V.emplace_back(0, 0), // dummy
-	V.emplace_back(1, 1),
-	id_map.emplace(bdd_key(hash_pair(0, 0), 0, 0), 0),
-	id_map.emplace(bdd_key(hash_pair(1, 1), 1, 1), 1),
+	C.resize(ite_cache_bytes),
+	V.emplace_back(0, 0), // dummy
+	V.emplace_back(1, 1), id_map.rebuild(),
 	htrue = bdd_handle::get(T), hfalse = bdd_handle::get(F);
 }
 
-#ifndef NOMMAP
-void bdd::max_bdd_size_check() {
-	if (V.size() == max_bdd_nodes)
-		CERR << "Maximum bdd size reached. Increase the limit"
-		" with --bdd-max-size parameter. Exiting." << endl,
-		onexit = true,
-		exit(0);
-		// TODO: offer user to remap instead of exit
-}
-#endif
-
 /* Make a BDD reference representing a function f that behaves like the provided
  * high reference, h, if v is set to 1, otherwise it behaves like the provided
  * low reference, l. Precondition is that h and l depend only on variables after
@@ -138,15 +401,18 @@ bdd_ref bdd::add(bdd_shft v, bdd_ref h, bdd_ref l) {
 	// attaching an input inverter if necessary. Required for canonicity.
 	const bool inv_inp = BDD_LT(l, h);
 	if (inv_inp) swap(h, l);
-	bdd_key k = bdd_key(hash_upair(h, l), h, l);
-	unordered_map<bdd_key, bdd_id>::const_iterator it;
 	// Find a BDD with the given high and low parts and make an attributed
 	// reference to it.
-	bdd_id id = (it = id_map.find(k)) != id_map.end() ? it->second :
-		(V.emplace_back(h, l),
-		id_map.emplace(move(k), V.size()-1),
-		V.size()-1);
-	return BDD_REF(id, v, inv_inp, inv_out);
+#ifdef WITH_THREADS
+	if (par) {
+		const bdd_id id = add_par(h, l);
+		return BDD_REF(id, v, inv_inp, inv_out);
+	}
+#endif
+	bdd_id& id = id_map.at(h, l);
+	if (id) return BDD_REF(id, v, inv_inp, inv_out);
+	const bdd_id r = id = new_node(h, l);
+	return id_map.added(), BDD_REF(r, v, inv_inp, inv_out);
 }
 
 bdd_ref bdd::from_bit(bdd_shft b, bool v) {
@@ -179,16 +445,24 @@ bdd_ref bdd::bdd_and(bdd_ref x, bdd_ref y) {
 	DECR_SHIFT(x, min_shift);
 	DECR_SHIFT(y, min_shift);
 	ite_memo m = { x, y, F };
-	auto it = C.find(m);
+	bdd_ref r;
 	// Upshift result to obtain answer for pre-downshifted BDDs
-	if (it != C.end()) return PLUS_SHIFT(it->second, min_shift);
+	if (C.find(m, r)) return PLUS_SHIFT(r, min_shift);
 	const bdd_shft xshift = GET_SHIFT(x), yshift = GET_SHIFT(y);
 	const bdd bx = get(x), by = get(y);
-	bdd_ref r;
-	if (xshift < yshift) r = add(xshift, bdd_and(bx.h, y), bdd_and(bx.l, y));
-	else if (xshift > yshift) r = add(yshift, bdd_and(x, by.h), bdd_and(x, by.l));
-	else r = add(xshift, bdd_and(bx.h, by.h), bdd_and(bx.l, by.l));
-	if (C.size() < gclimit) C.emplace(m, r);
+	bdd_ref h, l;
+	if (xshift < yshift)
+		fork2(h, [&] { return bdd_and(bx.h, y); },
+			l, [&] { return bdd_and(bx.l, y); }),
+		r = add(xshift, h, l);
+	else if (xshift > yshift)
+		fork2(h, [&] { return bdd_and(x, by.h); },
+			l, [&] { return bdd_and(x, by.l); }),
+		r = add(yshift, h, l);
+	else	fork2(h, [&] { return bdd_and(bx.h, by.h); },
+			l, [&] { return bdd_and(bx.l, by.l); }),
+		r = add(xshift, h, l);
+	C.insert(m, r);
 	// Upshift result to obtain answer for pre-downshifted BDDs
 	return PLUS_SHIFT(r, min_shift);
 }
@@ -217,32 +491,20 @@ bdd_ref bdd::bdd_ite(bdd_ref x, bdd_ref y, bdd_ref  z) {
 	DECR_SHIFT(x, min_shift);
 	DECR_SHIFT(y, min_shift);
 	DECR_SHIFT(z, min_shift);
-	auto it = C.find({x, y, z});
-	// If result in cache then upshift to obtain answer for pre-downshifted BDDs
-	if (it != C.end()) return PLUS_SHIFT(it->second, min_shift);
+	const ite_memo m = { x, y, z };
 	bdd_ref r;
+	// If result in cache then upshift to obtain answer for pre-downshifted BDDs
+	if (C.find(m, r)) return PLUS_SHIFT(r, min_shift);
 	const bdd bx = get(x), by = get(y), bz = get(z);
-	const bdd_shft xshift = GET_SHIFT(x), yshift = GET_SHIFT(y), zshift = GET_SHIFT(z);
-	if (xshift == yshift && yshift == zshift)
-		r =	add(xshift, bdd_ite(bx.h, by.h, bz.h),
-				bdd_ite(bx.l, by.l, bz.l));
-	else if (!xshift && !yshift)
-		r =	add(xshift, bdd_ite(bx.h, by.h, z),
-				bdd_ite(bx.l, by.l, z));
-	else if (!yshift && !zshift)
-		r =	add(yshift, bdd_ite(x, by.h, bz.h),
-				bdd_ite(x, by.l, bz.l));
-	else if (!xshift && !zshift)
-		r =	add(xshift, bdd_ite(bx.h, y, bz.h),
-				bdd_ite(bx.l, y, bz.l));
-	else if (!xshift)
-		r =	add(xshift, bdd_ite(bx.h, y, z), bdd_ite(bx.l, y, z));
-	else if (!yshift)
-		r =	add(yshift, bdd_ite(x, by.h, z), bdd_ite(x, by.l, z));
-	else	r =	add(zshift, bdd_ite(x, y, bz.h), bdd_ite(x, y, bz.l));
+	// After the downshift the operands rooted at the top variable have shift 0,
+	// only those are split.
+	const bool sx = !GET_SHIFT(x), sy = !GET_SHIFT(y), sz = !GET_SHIFT(z);
+	bdd_ref h, l;
+	fork2(h, [&] { return bdd_ite(sx ? bx.h : x, sy ? by.h : y, sz ? bz.h : z); },
+		l, [&] { return bdd_ite(sx ? bx.l : x, sy ? by.l : y, sz ? bz.l : z); });
+	r = add(0, h, l);
 	// Upshift result to obtain answer for pre-downshifted BDDs
-	if (C.size() > gclimit) return PLUS_SHIFT(r, min_shift);
-	return C.emplace(ite_memo{x, y, z}, r), PLUS_SHIFT(r, min_shift);
+	return C.insert(m, r), PLUS_SHIFT(r, min_shift);
 }
 
 void am_sort(bdds& b) {
@@ -310,15 +572,14 @@ bool subset(const bdds& small, const bdds& big) {
 }
 
 bdd_ref bdd::bdd_and_many(bdds v) {
-	static unordered_map<ite_memo, bdd_ref>::const_iterator jt;
 	for (size_t n = 0; n < v.size(); ++n)
 		for (size_t k = 0; k < n; ++k) {
-			bdd_ref x, y;
+			bdd_ref x, y, r;
 			if (v[n] < v[k]) x = v[n], y = v[k];
 			else x = v[k], y = v[n];
-			if ((jt = C.find({x, y, F})) != C.end()) {
+			if (C.find({x, y, F}, r)) {
 				v.erase(v.begin()+k), v.erase(v.begin()+n-1),
-				v.push_back(jt->second), n = k = 0;
+				v.push_back(r), n = k = 0;
 				break;
 			}
 		}
@@ -327,23 +588,21 @@ bdd_ref bdd::bdd_and_many(bdds v) {
 	am_sort(v);
 	if (v.empty()) return T;
 	if (v.size() == 1) return v[0];
-	auto it = AM.find(v);
-	if (it != AM.end()) return it->second;
-	if (v.size() == 2)
-		return AM.emplace(v, bdd_and(v[0], v[1])).first->second;
 	bdd_ref res = F, h, l;
+	if (memo_find(AM, v, res)) return res;
+	if (v.size() == 2) return memo_put(AM, v, bdd_and(v[0], v[1]));
 	bdd_shft m = 0;
 	bdds vh, vl;
 	switch (bdd_and_many_iter(v, vh, vl, res, m)) {
-		case 0: l = bdd_and_many(move(vl)),
-			h = bdd_and_many(move(vh));
+		case 0: fork2(h, [&] { return bdd_and_many(move(vh)); },
+				l, [&] { return bdd_and_many(move(vl)); });
 			break;
-		case 1: return AM.emplace(v, res), res;
+		case 1: return memo_put(AM, v, res), res;
 		case 2: h = bdd_and_many(move(vh)), l = F; break;
 		case 3: h = F, l = bdd_and_many(move(vl)); break;
 		default: { DBGFAIL; return 0; }
 	}
-	return AM.emplace(v, bdd::add(m, h, l)).first->second;
+	return memo_put(AM, v, bdd::add(m, h, l));
 }
 
 bdd_ref bdd::bdd_and_ex(bdd_ref x, bdd_ref y, const bools& ex,
@@ -402,22 +661,22 @@ struct sbdd_and_ex_perm {
 		if (y == T) return bdd::bdd_permute_ex(x, ex, p, last, m2);
 		if (x > y) swap(x, y);
 		array<bdd_ref, 2> m = {x, y};
-		auto it = memo.find(m);
-		if (it != memo.end()) return it->second;
+		bdd_ref rx, ry, r;
+		if (memo_find(memo, m, r)) return r;
 		const bdd bx = bdd::get(x), by = bdd::get(y);
 		bdd_shft v;
-		bdd_ref rx, ry, r;
 		if (GET_SHIFT(x) > last+1 && GET_SHIFT(y) > last+1)
-			return memo.emplace(m, r = bdd::bdd_and(x, y)), r;
-		if (GET_SHIFT(x) < GET_SHIFT(y))
-			v = GET_SHIFT(x), rx = (*this)(bx.h, y), ry = (*this)(bx.l, y);
-		else if (GET_SHIFT(x) > GET_SHIFT(y))
-			v = GET_SHIFT(y), rx = (*this)(x, by.h), ry = (*this)(x, by.l);
-		else v = GET_SHIFT(x), rx = (*this)(bx.h,by.h), ry = (*this)(bx.l,by.l);
+			return memo_put(memo, m, bdd::bdd_and(x, y));
+		// Split the operands rooted at the top variable v
+		const bool sx = GET_SHIFT(x) <= GET_SHIFT(y),
+			sy = GET_SHIFT(y) <= GET_SHIFT(x);
+		v = sx ? GET_SHIFT(x) : GET_SHIFT(y);
+		fork2(rx, [&] { return (*this)(sx ? bx.h : x, sy ? by.h : y); },
+			ry, [&] { return (*this)(sx ? bx.l : x, sy ? by.l : y); });
 		DBG(assert((size_t)v - 1 < ex.size());)
 		r = ex[v - 1] ? bdd::bdd_or(rx, ry) :
 			bdd::bdd_ite_var(p[v-1], rx, ry);
-		return memo.emplace(m, r), r;
+		return memo_put(memo, m, r), r;
 	}
 };
 
@@ -544,10 +803,9 @@ struct sbdd_and_many_ex_perm {
 		if (v.size() == 1)
 			return bdd::bdd_permute_ex(v[0], ex, p, last, m3);
 		if (v.size() == 2) return saep(v[0], v[1]);
-		auto it = memo.find(v);
-		if (it != memo.end()) return it->second;
 		bdd_shft m = 0;
 		bdd_ref res = F, h, l;
+		if (memo_find(memo, v, res)) return res;
 		bdds vh, vl;
 		char c = bdd::bdd_and_many_iter(v, vh, vl, res, m);
 		if (m > last+1) {
@@ -563,7 +821,8 @@ struct sbdd_and_many_ex_perm {
 			}
 		} else {
 			switch (c) {
-			case 0: l = (*this)(move(vl)), h = (*this)(move(vh));
+			case 0: fork2(h, [&] { return (*this)(move(vh)); },
+					l, [&] { return (*this)(move(vl)); });
 				if (ex[m - 1]) res = bdd::bdd_or(h, l);
 				else res = bdd::bdd_ite_var(p[m-1],h,l);
 				break;
@@ -579,7 +838,7 @@ struct sbdd_and_many_ex_perm {
 			default: DBGFAIL;
 			}
 		}
-		return memo.emplace(move(v), res), res;
+		return memo_put(memo, move(v), res), res;
 	}
 };
 
@@ -596,23 +855,72 @@ bdd_ref bdd::bdd_and_many_ex_perm(bdds v, const bools& ex, const bdd_shfts& p) {
 			memos_perm_ex[{p,ex}])(v);
 }
 
-void bdd::mark_all(bdd_ref i) {
-	DBG(assert((size_t)GET_BDD_ID(i) < V.size());)
-	if (GET_BDD_ID(i) >= 2 && !has(S, GET_BDD_ID(i)))
-		mark_all(hi(i)), mark_all(lo(i)), S.insert(GET_BDD_ID(i));
+/* Mark every node reachable from a live handle. An explicit stack is used so
+ * that deep BDDs cannot overflow the C++ stack. */
+
+void bdd::mark_all() {
+	vector<bdd_id> st;
+	S.reset(V.size()), S.insert(0), S.insert(1);
+	for (const auto& x : bdd_handle::M) st.push_back(GET_BDD_ID(x.first));
+	for (bdd_id n; !st.empty();) {
+		n = st.back(), st.pop_back();
+		DBG(assert((size_t)n < V.size());)
+		if (S.insert(n))
+			st.push_back(GET_BDD_ID(V[n].h)),
+			st.push_back(GET_BDD_ID(V[n].l));
+	}
 }
 
 /* Get the size of the ITE cache. */
 size_t bdd::get_ite_cache_size() { return C.size(); }
+/* Reallocate the ITE cache so that it fits into the given number of bytes. */
+void bdd::set_ite_cache_size(size_t new_ite_cache_bytes) {
+	if (new_ite_cache_bytes == ite_cache_bytes) return;
+	C.resize(ite_cache_bytes = new_ite_cache_bytes);
+}
+/* Run top level operations on the given number of threads, 1 meaning that
+ * everything runs sequentially on the calling thread. */
+void bdd::set_threads(size_t new_threads) {
+#ifdef WITH_THREADS
+	pool.reset();
+	if (new_threads > 1) pool = make_unique<bdd_pool>(new_threads);
+#else
+	(void) new_threads;
+#endif
+}
+/* Reorder the variables when a collection leaves at least the given number of
+ * live nodes, 0 disabling it. The limit doubles along with the database. */
+void bdd::set_reorder_limit(size_t new_reorder_limit) {
+	reorder_limit = new_reorder_limit;
+}
 /* Only trigger the garbage collector when given limit is exceeded */
 void bdd::set_gc_limit(size_t new_gc_limit) { gclimit = new_gc_limit; }
 /* Enable/disable the garbage collector depending on given argument */
 void bdd::set_gc_enabled(bool new_gc_enabled) { gc_enabled = new_gc_enabled; }
+/* Switch garbage collection strategy. Reference counts are recomputed from the
+ * current database when switching to GC_REFCOUNT. */
+void bdd::set_gc_mode(gc_mode new_gc_mode) {
+	refs.clear(), dead.clear();
+	if ((bdd_gc_mode = new_gc_mode) != GC_REFCOUNT) return;
+	refs.resize(V.size());
+	for (bdd_id n : free_ids) refs[n] = freed_ref;
+	for (size_t n = 2; n < V.size(); ++n)
+		if (refs[n] != freed_ref) incref(V[n].h), incref(V[n].l);
+	for (const auto& x : bdd_handle::M) incref(x.first);
+	for (size_t n = 2; n < V.size(); ++n) if (!refs[n]) dead.push_back(n);
+}
 
 template <typename T>
 basic_ostream<T>& bdd::stats(basic_ostream<T>& os) {
 	return os << "# S: " << S.size() << " V: "<< V.size() <<
-		" AM: " << AM.size() << " C: "<< C.size();
+		" AM: " << AM.size() << " C: "<< C.size() << "/" <<
+		C.capacity() << " (hits: " << C.hits << " misses: " <<
+		C.misses << " evictions: " << C.evictions << ")" <<
+		" gc: " << gc_runs << " (freed: " << gc_freed <<
+		" free: " << free_ids.size() << " pause: " << gc_pause_total <<
+		" ms max: " << gc_pause_max << " ms)" <<
+		" reorder: " << reorder_runs << " (nodes: " << reorder_before <<
+		" -> " << reorder_after << " time: " << reorder_time << " ms)";
 }
 template basic_ostream<char>& bdd::stats(basic_ostream<char>&);
 template basic_ostream<wchar_t>& bdd::stats(basic_ostream<wchar_t>&);
@@ -620,41 +928,78 @@ template basic_ostream<wchar_t>& bdd::stats(basic_ostream<wchar_t>&);
 void bdd::gc() {
 	if(!gc_enabled) return;
 	if (V.empty()) return;
-	S.clear();
-	for (auto x : bdd_handle::M) mark_all(x.first);
-	id_map.clear(), S.insert(0), S.insert(1);
-	vector<bdd_id> p(V.size(), 0);
+	const auto start = chrono::steady_clock::now();
+	if (bdd_gc_mode == GC_REFCOUNT) gc_refcount();
+	else gc_compact();
+	const double pause = chrono::duration<double, milli>(
+		chrono::steady_clock::now() - start).count();
+	++gc_runs, gc_pause_total += pause, gc_pause_max = max(gc_pause_max, pause);
+	if (bdd_gc_hook) bdd_gc_hook(start, pause);
+	if (reorder_limit && !reordering &&
+		V.size() - free_ids.size() >= reorder_limit)
+		reorder(), reorder_limit = max(reorder_limit, reorder_after << 1);
+}
+
+/* Free the nodes whose reference count is zero, cascading to their children.
+ * Nothing is moved: the freed ids are removed from the unique table and queued
+ * for reuse, and only the memo entries mentioning a freed node are dropped. The
+ * pause is proportional to the garbage and to the memos, not to V. */
+
+void bdd::gc_refcount() {
+	size_t n = 0;
+	for (bdd_id x; !dead.empty();)
+		if (x = dead.back(), dead.pop_back(), !refs[x])
+			id_map.erase(x), refs[x] = freed_ref, ++n,
+			decref(V[x].h), decref(V[x].l), V[x] = bdd(0, 0),
+			free_ids.push_back(x);
+	if (!(gc_freed = n)) return;
+	C.drop([](const ite_cache::entry& e) {
+		return freed(e.x) || freed(e.y) || freed(e.z) || freed(e.r);
+	});
+	auto f = [](const auto& x) { return freed(x.first) || freed(x.second); };
+	auto prune = [&f](auto& m) {
+		for (auto it = m.begin(); it != m.end();)
+			if (erase_if(it->second, f), it->second.empty())
+				it = m.erase(it);
+			else ++it;
+	};
+	prune(CX), prune(CXP), prune(AMX), prune(AMXP), prune(memos_ex),
+	prune(memos_perm), prune(memos_perm_ex), erase_if(AM, f);
+}
+
+void bdd::gc_compact() {
+	const size_t nodes = V.size();
+	mark_all(), S.index();
 #ifndef NOMMAP
-	bdd_mmap v1(memory_map_allocator<bdd>("", bdd_mmap_mode));
-	v1.reserve(bdd_mmap_mode == MMAP_NONE ? S.size() : max_bdd_nodes);
-#else
-	v1.reserve(S.size());
+	// A map is compacted in place instead of into a second one
+	if (bdd_mmap_mode != MMAP_NONE) {
+		size_t k = 0;
+		S.each([&k](bdd_id n) { V[k++] = V[n]; });
+		V.erase(V.begin() + k, V.end());
+	} else
 #endif
-	for (size_t n = 0; n < V.size(); ++n)
-		if (has(S, n)) p[n] = v1.size(), v1.emplace_back(move(V[n]));
-	V = move(v1);
-#define f(i) (SET_BDD_ID(i, (p[GET_BDD_ID(i)] ? p[GET_BDD_ID(i)] : GET_BDD_ID(i))), i)
-	for (size_t n = 2; n < V.size(); ++n) {
-		DBG(assert(p[GET_BDD_ID(V[n].h)] && p[GET_BDD_ID(V[n].l)]);)
-		f(V[n].h), f(V[n].l);
+	{
+		bdd_mmap v1;
+		v1.reserve(S.size());
+		S.each([&v1](bdd_id n) { v1.emplace_back(move(V[n])); });
+		V = move(v1);
 	}
-	unordered_map<ite_memo, bdd_ref> c;
+#define f(i) (SET_BDD_ID(i, S.rank(GET_BDD_ID(i))), i)
+	for (size_t n = 2; n < V.size(); ++n) f(V[n].h), f(V[n].l);
 	unordered_map<bdds, bdd_ref> am;
-	for (pair<ite_memo, bdd_ref> x : C)
-		if (	has(S, GET_BDD_ID(x.first.x)) &&
-			has(S, GET_BDD_ID(x.first.y)) &&
-			has(S, GET_BDD_ID(x.first.z)) &&
-			has(S, GET_BDD_ID(x.second)))
-			f(x.first.x), f(x.first.y), f(x.first.z),
-			x.first.rehash(), c.emplace(x.first, f(x.second));
-	C = move(c);
+	C.remap([](ite_cache::entry& e) {
+		if (	!S.marked(GET_BDD_ID(e.x)) || !S.marked(GET_BDD_ID(e.y)) ||
+			!S.marked(GET_BDD_ID(e.z)) || !S.marked(GET_BDD_ID(e.r)))
+			return false;
+		return f(e.x), f(e.y), f(e.z), f(e.r), true;
+	});
 	map<bools, unordered_map<array<bdd_ref, 2>, bdd_ref>, veccmp<bool>> cx;
 	unordered_map<array<bdd_ref, 2>, bdd_ref> cc;
 	for (const auto& x : CX) {
 		for (pair<array<bdd_ref, 2>, bdd_ref> y : x.second)
-			if (	has(S, GET_BDD_ID(y.first[0])) &&
-				has(S, GET_BDD_ID(y.first[1])) &&
-				has(S, GET_BDD_ID(y.second)))
+			if (	S.marked(GET_BDD_ID(y.first[0])) &&
+				S.marked(GET_BDD_ID(y.first[1])) &&
+				S.marked(GET_BDD_ID(y.second)))
 				f(y.first[0]), f(y.first[1]),
 				cc.emplace(y.first, f(y.second));
 		if (!cc.empty()) cx.emplace(x.first, move(cc));
@@ -664,9 +1009,9 @@ void bdd::gc() {
 		vec2cmp<bool, bdd_shft>> cxp;
 	for (const auto& x : CXP) {
 		for (pair<array<bdd_ref, 2>, bdd_ref> y : x.second)
-			if (	has(S, GET_BDD_ID(y.first[0])) &&
-				has(S, GET_BDD_ID(y.first[1])) &&
-				has(S, GET_BDD_ID(y.second)))
+			if (	S.marked(GET_BDD_ID(y.first[0])) &&
+				S.marked(GET_BDD_ID(y.first[1])) &&
+				S.marked(GET_BDD_ID(y.second)))
 				f(y.first[0]), f(y.first[1]),
 				cc.emplace(y.first, f(y.second));
 		if (!cc.empty()) cxp.emplace(x.first, move(cc));
@@ -676,7 +1021,7 @@ void bdd::gc() {
 	map<bools, unordered_map<bdd_ref, bdd_ref>, veccmp<bool>> mex;
 	for (const auto& x : memos_ex) {
 		for (pair<bdd_ref, bdd_ref> y : x.second)
-			if (has(S, GET_BDD_ID(y.first)) && has(S, GET_BDD_ID(y.second)))
+			if (S.marked(GET_BDD_ID(y.first)) && S.marked(GET_BDD_ID(y.second)))
 				q.emplace(f(y.first), f(y.second));
 		if (!q.empty()) mex.emplace(x.first, move(q));
 	}
@@ -684,7 +1029,7 @@ void bdd::gc() {
 	map<bdd_shfts, unordered_map<bdd_ref, bdd_ref>, veccmp<bdd_shft>> mp;
 	for (const auto& x : memos_perm) {
 		for (pair<bdd_ref, bdd_ref> y : x.second)
-			if (has(S, GET_BDD_ID(y.first)) && has(S, GET_BDD_ID(y.second)))
+			if (S.marked(GET_BDD_ID(y.first)) && S.marked(GET_BDD_ID(y.second)))
 				q.emplace(f(y.first), f(y.second));
 		if (!q.empty()) mp.emplace(x.first, move(q));
 	}
@@ -693,7 +1038,7 @@ void bdd::gc() {
 		vec2cmp<bdd_shft, bool>> mpe;
 	for (const auto& x : memos_perm_ex) {
 		for (pair<bdd_ref, bdd_ref> y : x.second)
-			if (has(S, GET_BDD_ID(y.first)) && has(S, GET_BDD_ID(y.second)))
+			if (S.marked(GET_BDD_ID(y.first)) && S.marked(GET_BDD_ID(y.second)))
 				q.emplace(f(y.first), f(y.second));
 		if (!q.empty()) mpe.emplace(x.first, move(q));
 	}
@@ -704,9 +1049,9 @@ void bdd::gc() {
 		for (pair<bdds, bdd_ref> y : x.second) {
 			b = false;
 			for (bdd_ref& i : y.first)
-				if ((b |= !has(S, GET_BDD_ID(i)))) break;
+				if ((b |= !S.marked(GET_BDD_ID(i)))) break;
 				else f(i);
-			if (!b && has(S, GET_BDD_ID(y.second)))
+			if (!b && S.marked(GET_BDD_ID(y.second)))
 				am.emplace(y.first, f(y.second));
 		}
 		if (!am.empty()) amx.emplace(x.first, move(am));
@@ -718,9 +1063,9 @@ void bdd::gc() {
 		for (pair<bdds, bdd_ref> y : x.second) {
 			b = false;
 			for (bdd_ref& i : y.first)
-				if ((b |= !has(S, GET_BDD_ID(i)))) break;
+				if ((b |= !S.marked(GET_BDD_ID(i)))) break;
 				else f(i);
-			if (!b && has(S, GET_BDD_ID(y.second)))
+			if (!b && S.marked(GET_BDD_ID(y.second)))
 				am.emplace(y.first, f(y.second));
 		}
 		if (!am.empty()) amxp.emplace(x.first, move(am));
@@ -729,19 +1074,16 @@ void bdd::gc() {
 	for (pair<bdds, bdd_ref> x : AM) {
 		b = false;
 		for (bdd_ref& i : x.first)
-			if ((b |= !has(S, GET_BDD_ID(i)))) break;
+			if ((b |= !S.marked(GET_BDD_ID(i)))) break;
 			else f(i);
-		if (!b&&has(S,GET_BDD_ID(x.second))) am.emplace(x.first, f(x.second));
+		if (!b&&S.marked(GET_BDD_ID(x.second))) am.emplace(x.first, f(x.second));
 	}
-	AM=move(am), bdd_handle::update(p);
-	p.clear(), S.clear();
-	std::hash<bdd_ref> hsh;
-	for (size_t n = 0; n < V.size(); ++n)
-		id_map.emplace(bdd_key(hash_upair(hsh(V[n].h), hsh(V[n].l)),
-			V[n].h, V[n].l), n);
+	AM=move(am), bdd_handle::update();
+	gc_freed = nodes - V.size();
+	S.clear(), free_ids.clear(), id_map.rebuild();
 }
 
-void bdd_handle::update(const vector<bdd_id>& p) {
+void bdd_handle::update() {
 	unordered_map<bdd_ref, weak_ptr<bdd_handle>> m;
 	for (pair<bdd_ref, weak_ptr<bdd_handle>> x : M)
 		if (!x.second.expired())
@@ -750,14 +1092,132 @@ void bdd_handle::update(const vector<bdd_id>& p) {
 }
 #undef f
 
+/* Rename the physical levels of x to logical variables and back. */
+bdd_ref bdd::to_logical(bdd_ref x) {
+	if (level_var.empty()) return x;
+	return bdd_permute(x, level_var, memos_perm[level_var]);
+}
+
+bdd_ref bdd::to_physical(bdd_ref x) {
+	if (var_level.empty()) return x;
+	return bdd_permute(x, var_level, memos_perm[var_level]);
+}
+
+size_t bdd::live_nodes() { return mark_all(), S.size(); }
+
+/* Replace the root of every live handle by f of it. */
+template <typename F> void bdd::rebind(F f) {
+	unordered_map<bdd_ref, weak_ptr<bdd_handle>> m;
+	for (const auto& x : bdd_handle::M) {
+		spbdd_handle h = x.second.lock();
+		h->b = f(x.first);
+		if (bdd_gc_mode == GC_REFCOUNT) incref(h->b), decref(x.first);
+		m.emplace(h->b, x.second);
+	}
+	bdd_handle::M = move(m);
+}
+
+/* Exchange the physical levels k and k+1. Nodes carry no level of their own,
+ * their variables being relative to the incoming edges, so the swap cannot be
+ * done in place: every root is rebuilt through a transposition, which leaves
+ * the levels below k+1 untouched. */
+void bdd::swap_levels(bdd_shft k) {
+	bdd_shfts p(k + 2);
+	for (bdd_shft n = 0; n != k; ++n) p[n] = n;
+	p[k] = k + 1, p[k + 1] = k;
+	unordered_map<bdd_ref, bdd_ref> memo;
+	rebind([&p, &memo](bdd_ref x) { return bdd_permute(x, p, memo); });
+	swap(level_var[k], level_var[k + 1]);
+	var_level[level_var[k]] = k, var_level[level_var[k + 1]] = k + 1;
+}
+
+/* Sift the logical variable v: move it toward the closer end of the order,
+ * then toward the other end, and leave it at the level where the fewest nodes
+ * were live. A direction is abandoned once the size exceeds 1.2 times the best
+ * one. size is the current number of live nodes, the best one is returned. */
+size_t bdd::sift(bdd_shft v, size_t size) {
+	const bdd_shft n = var_level.size();
+	bdd_shft to = var_level[v];
+	size_t best = size;
+	auto step = [&size](bdd_shft k) {
+		swap_levels(k), ++reorder_swaps;
+		if (V.size() > (size << 1) + 4096) gc();
+		return size = live_nodes();
+	};
+	auto down = [&] {
+		while (var_level[v] + 1 < n && reorder_swaps < reorder_max_swaps)
+			if (step(var_level[v]) < best) best = size, to = var_level[v];
+			else if (size * 5 > best * 6) break;
+	};
+	auto up = [&] {
+		while (var_level[v] && reorder_swaps < reorder_max_swaps)
+			if (step(var_level[v] - 1) < best) best = size, to = var_level[v];
+			else if (size * 5 > best * 6) break;
+	};
+	if (var_level[v] < n / 2) up(), down();
+	else down(), up();
+	while (var_level[v] < to) step(var_level[v]);
+	while (var_level[v] > to) step(var_level[v] - 1);
+	return best;
+}
+
+/* Reorder the variables by sifting them one by one, those on the most crowded
+ * levels first and within the limits above. The mapping between the logical variables used by the callers
+ * and the physical levels is kept in var_level and level_var. */
+void bdd::reorder() {
+	if (!gc_enabled || reordering || bdd_handle::M.empty()) return;
+	const auto start = chrono::steady_clock::now();
+	reordering = true, gc();
+	// Count the distinct references branching on each level
+	vector<size_t> w(var_level.size());
+	unordered_set<bdd_ref> s;
+	bdds st;
+	for (const auto& x : bdd_handle::M) st.push_back(x.first);
+	for (bdd_ref x; !st.empty();)
+		if (x = BDD_ABS(st.back()), st.pop_back(),
+			!leaf(x) && s.insert(x).second) {
+			if (w.size() < var(x)) w.resize(var(x));
+			++w[var(x) - 1], st.push_back(hi(x)), st.push_back(lo(x));
+		}
+	s.clear();
+	for (bdd_shft n = var_level.size(); n < w.size(); ++n)
+		var_level.push_back(n), level_var.push_back(n);
+	bdd_shfts vs(w.size());
+	for (bdd_shft n = 0; n != vs.size(); ++n) vs[n] = n;
+	sort(vs.begin(), vs.end(), [&w](bdd_shft x, bdd_shft y) {
+		return w[var_level[x]] > w[var_level[y]];
+	});
+	if (vs.size() > reorder_max_vars) vs.resize(reorder_max_vars);
+	size_t size = reorder_before = live_nodes();
+	reorder_swaps = 0;
+	if (vs.size() > 1) for (bdd_shft v : vs) size = sift(v, size);
+	reorder_after = size;
+	bool id = true;
+	for (bdd_shft n = 0; id && n != var_level.size(); ++n)
+		id = var_level[n] == n;
+	if (id) var_level.clear(), level_var.clear();
+	gc(), reordering = false, ++reorder_runs;
+	reorder_time = chrono::duration<double, milli>(
+		chrono::steady_clock::now() - start).count();
+}
+
 spbdd_handle bdd_handle::get(bdd_ref  b) {
 	DBG(assert((size_t)GET_BDD_ID(b) < V.size());)
 	auto it = M.find(b);
 	if (it != M.end()) return it->second.lock();
 	spbdd_handle h(new bdd_handle(b));
+	if (bdd_gc_mode == GC_REFCOUNT) incref(b);
 	return M.emplace(b, weak_ptr<bdd_handle>(h)), h;
 }
 
+bdd_handle::~bdd_handle() {
+	if (onexit) return;
+	if (GET_BDD_ID(b) > 1) {
+		M.erase(b);
+		if (bdd_gc_mode == GC_REFCOUNT) decref(b);
+	}
+}
+
 void bdd::bdd_sz(bdd_ref x, set<bdd_ref>& s) {
 	if (!s.emplace(x).second) return;
 	bdd b = get(x);
@@ -765,15 +1225,18 @@ void bdd::bdd_sz(bdd_ref x, set<bdd_ref>& s) {
 }
 
 spbdd_handle operator&&(cr_spbdd_handle x, cr_spbdd_handle y) {
+	par_section p;
 	spbdd_handle r = bdd_handle::get(bdd::bdd_and(x->b, y->b));
 	return r;
 }
 
 spbdd_handle operator%(cr_spbdd_handle x, cr_spbdd_handle y) {
+	par_section p;
 	return bdd_handle::get(bdd::bdd_and(x->b, FLIP_INV_OUT(y->b)));
 }
 
 spbdd_handle operator||(cr_spbdd_handle x, cr_spbdd_handle y) {
+	par_section p;
 	return bdd_handle::get(bdd::bdd_or(x->b, y->b));
 }
 
@@ -786,15 +1249,17 @@ bool bdd_subsumes(cr_spbdd_handle x, cr_spbdd_handle y) {
 }
 
 spbdd_handle bdd_ite(cr_spbdd_handle x, cr_spbdd_handle y, cr_spbdd_handle z) {
+	par_section p;
 	return bdd_handle::get(bdd::bdd_ite(x->b, y->b, z->b));
 }
 
 spbdd_handle bdd_ite_var(bdd_shft x, cr_spbdd_handle y, cr_spbdd_handle z) {
-	return bdd_handle::get(bdd::bdd_ite_var(x, y->b, z->b));
+	return bdd_handle::get(bdd::bdd_ite_var(level(x), y->b, z->b));
 }
 
 spbdd_handle bdd_and_many(bdd_handles v) {
-	if (V.size() >= gclimit) bdd::gc();
+	if (gc_due()) bdd::gc();
+	par_section p;
 	bdds b;
 	b.reserve(v.size());
 	for (size_t n = 0; n != v.size(); ++n) b.push_back(v[n]->b);
@@ -804,7 +1269,7 @@ spbdd_handle bdd_and_many(bdd_handles v) {
 }
 
 spbdd_handle bdd_and_many_ex(bdd_handles v, const bools& ex) {
-	if (V.size() >= gclimit) bdd::gc();
+	if (gc_due()) bdd::gc();
 	bool t = false;
 	for (bool x : ex) t |= x;
 	if (!t) return bdd_and_many(move(v));
@@ -812,51 +1277,91 @@ spbdd_handle bdd_and_many_ex(bdd_handles v, const bools& ex) {
 	b.reserve(v.size());
 	for (size_t n = 0; n != v.size(); ++n) b.push_back(v[n]->b);
 	am_sort(b);
-	auto r = bdd_handle::get(bdd::bdd_and_many_ex(move(b), ex));
+	auto r = bdd_handle::get(bdd::bdd_and_many_ex(move(b), levels(ex)));
 	return r;
 }
 
 spbdd_handle bdd_and_many_ex_perm(bdd_handles v, const bools& ex,
 	const bdd_shfts& p) {
-	if (V.size() >= gclimit) bdd::gc();
+	if (gc_due()) bdd::gc();
+	par_section s;
 	bdds b;
 	b.reserve(v.size());
 	for (size_t n = 0; n != v.size(); ++n) b.push_back(v[n]->b);
 	am_sort(b);
-	auto r = bdd_handle::get(bdd::bdd_and_many_ex_perm(move(b), ex, p));
+	auto r = bdd_handle::get(
+		bdd::bdd_and_many_ex_perm(move(b), levels(ex), levels(p)));
 	return r;
 }
 
+/* Disjunction of b as a balanced tree of bdd_or, its halves being reduced in
+ * parallel if possible. */
+
 bdd_ref bdd_or_reduce(bdds b) {
 	if (b.empty()) return F;
 	if (b.size() == 1) return b[0];
 	if (b.size() == 2) return bdd::bdd_or(b[0], b[1]);
-	bdd_ref t = F;
-	if (b.size() & 1) t = b.back(), b.erase(b.begin()+b.size()-1);
-	bdds x(b.size()>>1);
-	for (size_t n = 0; n != x.size(); ++n)
-		x[n] = bdd::bdd_or(b[n<<1], b[1+(n<<1)]);
-	return bdd::bdd_or(t, bdd_or_reduce(move(x)));
+	const auto k = b.begin() + (b.size() >> 1);
+	bdd_ref x, y;
+	fork2(x, [&] { return bdd_or_reduce(bdds(b.begin(), k)); },
+		y, [&] { return bdd_or_reduce(bdds(k, b.end())); });
+	return bdd::bdd_or(x, y);
 }
 
 spbdd_handle bdd_or_many(bdd_handles v) {
+	par_section p;
 	bdds b(v.size());
 	for (size_t n = 0; n != v.size(); ++n) b[n] = v[n]->b;
 	return bdd_handle::get(bdd_or_reduce(move(b)));
 }
 
 spbdd_handle from_high(bdd_shft s, bdd_ref x) {
+	if (!var_level.empty()) return from_high_and_low(s, x, F);
 	return bdd_handle::get(bdd::add(s + 1, x, F));
 }
 
 spbdd_handle from_low(bdd_shft s, bdd_ref y) {
+	if (!var_level.empty()) return from_high_and_low(s, F, y);
 	return bdd_handle::get(bdd::add(s + 1, F, y));
 }
 
 spbdd_handle from_high_and_low(bdd_shft s, bdd_ref x, bdd_ref y) {
+	// Once reordered x and y may branch on levels above s
+	if (!var_level.empty())
+		return bdd_handle::get(bdd::bdd_ite_var(level(s), x, y));
 	return bdd_handle::get(bdd::add(s + 1, x, y));
 }
 
+/* The bdd of n paths over the first nvars variables, sorted in their order and
+ * unique, given by the first variable diff(k) on which the paths k and k + 1
+ * differ and by the value bit(k, v) of the variable v on the path k. It is
+ * built bottom up in one pass: each path is closed up to the variable on
+ * which it differs from the next one, where it becomes the low branch of the
+ * path of the next one. */
+
+spbdd_handle from_sorted_paths(size_t n, bdd_shft nvars,
+	const function<bdd_shft(size_t)>& diff,
+	const function<bool(size_t, bdd_shft)>& bit)
+{
+	if (!n) return hfalse;
+	bdds lo(nvars, F);
+	auto node = [](bdd_shft v, bdd_ref h, bdd_ref l) {
+		return var_level.empty() ? bdd::add(v + 1, h, l)
+			: bdd::bdd_ite_var(level(v), h, l);
+	};
+	auto close = [&](size_t k, bdd_shft to) {
+		bdd_ref c = T;
+		for (bdd_shft v = nvars; v-- != to; lo[v] = F)
+			c = bit(k, v) ? node(v, c, lo[v]) : node(v, F, c);
+		return c;
+	};
+	for (size_t k = 1; k != n; ++k) {
+		const bdd_shft v = diff(k - 1);
+		lo[v] = close(k - 1, v + 1);
+	}
+	return bdd_handle::get(close(n - 1, 0));
+}
+
 void bdd::sat(bdd_shft v, bdd_shft nvars, bdd_ref  t, bools& p, vbools& r) {
 	if (t == F) return;
 	if (!leaf(t) && v < var(t))
@@ -875,7 +1380,7 @@ vbools bdd::allsat(bdd_ref x, bdd_shft nvars) {
 }
 
 vbools allsat(cr_spbdd_handle x, bdd_shft nvars) {
-	return bdd::allsat(x->b, nvars);
+	return bdd::allsat(bdd::to_logical(x->b), nvars);
 }
 
 void allsat_cb::sat(bdd_ref x) {
@@ -890,6 +1395,24 @@ void allsat_cb::sat(bdd_ref x) {
 	else f(p, x);
 }
 
+void allcubes_cb::sat(bdd_ref x) {
+	if (x == F) return;
+	if (bdd::leaf(x)) {
+		const size_t n = dc.size();
+		for (bdd_shft k = v; k <= nvars; ++k)
+			dc.push_back(k - 1), p[k - 1] = false;
+		return f(p, dc), dc.resize(n);
+	}
+	if (v < bdd::var(x)) {
+		DBG(assert(bdd::var(x) <= nvars);)
+		dc.push_back(v - 1), p[v - 1] = false, ++v, sat(x), --v,
+		dc.pop_back();
+		return;
+	}
+	const bdd bx = bdd::get(x);
+	p[++v-2] = true, sat(bx.h), p[v-2] = false, sat(bx.l), --v;
+}
+
 bdd_ref bdd::bdd_ex(bdd_ref x, const bools& b, unordered_map<bdd_ref, bdd_ref>& memo,
 	bdd_shft last) {
 	if (leaf(x) || var(x) > last+1) return x;
@@ -908,7 +1431,7 @@ bdd_ref bdd::bdd_ex(bdd_ref x, const bools& b) {
 }
 
 spbdd_handle operator/(cr_spbdd_handle x, const bools& b) {
-	return bdd_handle::get(bdd::bdd_ex(x->b, b));
+	return bdd_handle::get(bdd::bdd_ex(x->b, levels(b)));
 }
 
 bdd_ref bdd::bdd_permute(bdd_ref x, const bdd_shfts& m,
@@ -922,24 +1445,24 @@ bdd_ref bdd::bdd_permute(bdd_ref x, const bdd_shfts& m,
 }
 
 spbdd_handle operator^(cr_spbdd_handle x, const bdd_shfts& m) {
-	return bdd_handle::get(bdd::bdd_permute(x->b, m, memos_perm[m]));
+	const bdd_shfts p = levels(m);
+	return bdd_handle::get(bdd::bdd_permute(x->b, p, memos_perm[p]));
 }
 
 bdd_ref bdd::bdd_permute_ex(bdd_ref x, const bools& b, const bdd_shfts& m, bdd_shft last,
 	unordered_map<bdd_ref, bdd_ref>& memo) {
 	if (leaf(x) || var(x) > last+1) return x;
-	auto it = memo.find(x);
-	if (it != memo.end()) return it->second;
-	bdd_ref t = x, y = x;
+	bdd_ref t = x, y = x, h, l;
+	if (memo_find(memo, x, h)) return h;
 	DBG(assert(b.size() >= var(x));)
 	for (bdd_ref r; var(y)-1 < b.size() && b[var(y)-1]; y = r)
 		if (leaf((r = bdd_or(hi(y), lo(y)))))
-			return memo.emplace(t, r), r;
+			return memo_put(memo, t, r), r;
 		DBG(else assert(b.size() >= var(r));)
 	DBG(assert(!leaf(y) && m.size() >= var(y));)
-	return	memo.emplace(t, bdd_ite_var(m[var(y)-1],
-		bdd_permute_ex(hi(y), b, m, last, memo),
-		bdd_permute_ex(lo(y), b, m, last, memo))).first->second;
+	fork2(h, [&] { return bdd_permute_ex(hi(y), b, m, last, memo); },
+		l, [&] { return bdd_permute_ex(lo(y), b, m, last, memo); });
+	return memo_put(memo, t, bdd_ite_var(m[var(y)-1], h, l));
 }
 
 bdd_ref bdd::bdd_permute_ex(bdd_ref x, const bools& b, const bdd_shfts& m) {
@@ -950,32 +1473,35 @@ bdd_ref bdd::bdd_permute_ex(bdd_ref x, const bools& b, const bdd_shfts& m) {
 
 spbdd_handle bdd_permute_ex(cr_spbdd_handle x, const bools& b, const bdd_shfts& m) {
 
-	return bdd_handle::get(bdd::bdd_permute_ex(x->b, b, m));
+	return bdd_handle::get(bdd::bdd_permute_ex(x->b, levels(b), levels(m)));
 }
 
 spbdd_handle bdd_and_ex_perm(cr_spbdd_handle x, cr_spbdd_handle y,
 	const bools& b, const bdd_shfts& m) {
 
-	return bdd_handle::get(bdd::bdd_and_ex_perm(x->b, y->b, b, m));
+	return bdd_handle::get(
+		bdd::bdd_and_ex_perm(x->b, y->b, levels(b), levels(m)));
 }
 
 spbdd_handle bdd_and_ex(cr_spbdd_handle x, cr_spbdd_handle y,
 	const bools& b) {
-	return bdd_handle::get(bdd::bdd_and_ex(x->b, y->b, b));
+	return bdd_handle::get(bdd::bdd_and_ex(x->b, y->b, levels(b)));
 }
 
 spbdd_handle bdd_and_not_ex(cr_spbdd_handle x, cr_spbdd_handle y,
 	const bools& b) {
-	return bdd_handle::get(bdd::bdd_and_ex(x->b, FLIP_INV_OUT(y->b), b));
+	return bdd_handle::get(
+		bdd::bdd_and_ex(x->b, FLIP_INV_OUT(y->b), levels(b)));
 }
 
 spbdd_handle bdd_and_not_ex_perm(cr_spbdd_handle x, cr_spbdd_handle y,
 	const bools& b, const bdd_shfts& m) {
-	return bdd_handle::get(bdd::bdd_and_ex_perm(x->b, FLIP_INV_OUT(y->b), b, m));
+	return bdd_handle::get(bdd::bdd_and_ex_perm(
+		x->b, FLIP_INV_OUT(y->b), levels(b), levels(m)));
 }
 
 spbdd_handle from_bit(bdd_shft b, bool v) {
-	return bdd_handle::get(bdd::from_bit(b, v));
+	return bdd_handle::get(bdd::from_bit(level(b), v));
 }
 
 spbdd_handle from_eq(bdd_shft x, bdd_shft y) {
@@ -993,8 +1519,9 @@ bool bdd::solve(bdd_ref x, bdd_shft v, bdd_ref& l, bdd_ref &h) {
 
 array<spbdd_handle, 2> solve(spbdd_handle x, bdd_shft v) {
 	bdd_ref h, l;
-	if (!bdd::solve(x->b, v, h, l)) return { nullptr, nullptr };
-	return { bdd_handle::get(l), bdd_handle::get(h) };
+	if (!bdd::solve(bdd::to_logical(x->b), v, h, l)) return { nullptr, nullptr };
+	return { bdd_handle::get(bdd::to_physical(l)),
+		bdd_handle::get(bdd::to_physical(h)) };
 }
 
 void bdd::bdd_nvars(bdd_ref x, set<bdd_shft>& s) {
@@ -1009,13 +1536,221 @@ bdd_shft bdd::bdd_nvars(bdd_ref x) {
 	return r;
 }
 
+big_uint& big_uint::operator+=(const big_uint& x) {
+	if (d.size() < x.d.size()) d.resize(x.d.size());
+	uint64_t c = 0;
+	for (size_t n = 0; n != d.size(); ++n)
+		c += (uint64_t) d[n] + (n < x.d.size() ? x.d[n] : 0),
+		d[n] = (uint32_t) c, c >>= 32;
+	if (c) d.push_back((uint32_t) c);
+	return *this;
+}
+
+big_uint& big_uint::operator-=(const big_uint& x) {
+	DBG(assert(d.size() >= x.d.size());)
+	int64_t c = 0;
+	for (size_t n = 0; n != d.size(); ++n)
+		c += (int64_t) d[n] - (n < x.d.size() ? x.d[n] : 0),
+		d[n] = (uint32_t) c, c = c < 0 ? -1 : 0;
+	return trim(), *this;
+}
+
+big_uint& big_uint::operator<<=(size_t k) {
+	if (d.empty()) return *this;
+	const size_t s = k & 31;
+	d.push_back(0);
+	if (s) for (size_t n = d.size() - 1; n; --n)
+		d[n] = d[n] << s | d[n - 1] >> (32 - s);
+	d[0] <<= s;
+	return d.insert(d.begin(), k >> 5, 0), trim(), *this;
+}
+
+big_uint& big_uint::operator>>=(size_t k) {
+	const size_t w = k >> 5, s = k & 31;
+	if (w >= d.size()) return d.clear(), *this;
+	d.erase(d.begin(), d.begin() + w);
+	if (s) for (size_t n = 0; n != d.size(); ++n)
+		d[n] = d[n] >> s | (n + 1 < d.size() ? d[n + 1] << (32 - s) : 0);
+	return trim(), *this;
+}
+
+string big_uint::to_string() const {
+	if (d.empty()) return "0";
+	const uint64_t p = 1000000000;
+	vector<uint32_t> q(d), r;
+	// Divide by 10^9 until nothing is left, collecting the remainders
+	while (!q.empty()) {
+		uint64_t c = 0;
+		for (size_t n = q.size(); n--;)
+			c = c << 32 | q[n], q[n] = (uint32_t) (c / p), c %= p;
+		r.push_back((uint32_t) c);
+		while (!q.empty() && !q.back()) q.pop_back();
+	}
+	string s = std::to_string(r.back());
+	for (size_t n = r.size() - 1; n--;) {
+		string t = std::to_string(r[n]);
+		s += string(9 - t.size(), '0') + t;
+	}
+	return s;
+}
+
+template <typename T>
+basic_ostream<T>& operator<<(basic_ostream<T>& os, const big_uint& x) {
+	for (char c : x.to_string()) os << (T) c;
+	return os;
+}
+template basic_ostream<char>& operator<<(basic_ostream<char>&, const big_uint&);
+template basic_ostream<wchar_t>& operator<<(basic_ostream<wchar_t>&,
+	const big_uint&);
+
+/* Count the models of the node x over the levels it spans, from its variable
+ * to its deepest one. Input inversion does not change the count, so nodes are
+ * counted once whatever the references to them. */
+
+const pair<bdd_shft, big_uint>& bdd::bdd_count(bdd_id x,
+	unordered_map<bdd_id, pair<bdd_shft, big_uint>>& memo) {
+	auto it = memo.find(x);
+	if (it != memo.end()) return it->second;
+	const bdd b = V[x];
+	const pair<bdd_shft, big_uint> *c[2] = { 0, 0 };
+	const bdd_ref e[2] = { b.h, b.l };
+	bdd_shft span = 1;
+	for (size_t n = 0; n != 2; ++n)
+		if (!leaf(e[n])) c[n] = &bdd_count(GET_BDD_ID(e[n]), memo),
+			span = max(span, GET_SHIFT(e[n]) + c[n]->first);
+	big_uint r;
+	for (size_t n = 0; n != 2; ++n) {
+		big_uint y;
+		if (!c[n]) y = trueleaf(e[n]) ? big_uint::pow2(span - 1) : 0;
+		else {
+			y = c[n]->second;
+			if (GET_INV_OUT(e[n]))
+				y = big_uint::pow2(c[n]->first) -= y;
+			y <<= span - 1 - c[n]->first;
+		}
+		r += y;
+	}
+	return memo.emplace(x, make_pair(span, move(r))).first->second;
+}
+
+/* Count the models of x over the variables 0 to nvars-1. The count is linear in
+ * the size of x. */
+
+big_uint bdd::bdd_count(bdd_ref x, bdd_shft nvars) {
+	if (x == F) return 0;
+	if (x == T) return big_uint::pow2(nvars);
+	unordered_map<bdd_id, pair<bdd_shft, big_uint>> memo;
+	const auto& c = bdd_count(GET_BDD_ID(x), memo);
+	big_uint r = c.second;
+	if (GET_INV_OUT(x)) r = big_uint::pow2(c.first) -= r;
+	// The variables out of the span of x are free
+	return (r <<= nvars) >>= c.first;
+}
+
+bdd_stats bdd_get_stats() {
+	return { nodes_added, C.hits, C.misses, memo_hits, memo_misses };
+}
+
+big_uint bdd_count(cr_spbdd_handle x, bdd_shft nvars) {
+	return bdd::bdd_count(x->b, nvars);
+}
+
+/* Number the nodes under x from 2 on in the order they are written, children
+ * first. */
+
+void bdd::write(bdd_id x, unordered_map<bdd_id, bdd_id>& ids, bdds& v) {
+	if (x <= 1 || ids.find(x) != ids.end()) return;
+	const bdd b = V[x];
+	write(GET_BDD_ID(b.h), ids, v), write(GET_BDD_ID(b.l), ids, v);
+	for (bdd_ref y : { b.h, b.l }) {
+		if (GET_BDD_ID(y) > 1) SET_BDD_ID(y, ids.at(GET_BDD_ID(y)));
+		v.push_back(y);
+	}
+	ids.emplace(x, ids.size() + 2);
+}
+
+/* Write the count of the nodes reachable from the given roots, these nodes
+ * children first and then the count of the roots and the roots. References
+ * keep their shifts and inverters and only have their ids renumbered, so the
+ * image depends neither on where the nodes were in V nor, the roots being
+ * made logical first, on the order of the variables. */
+
+void bdd::write(ostream& os, const bdds& roots) {
+	auto put = [&os](uint64_t x) { os.write((const char*) &x, sizeof x); };
+	unordered_map<bdd_id, bdd_id> ids;
+	bdds v, r;
+	for (bdd_ref x : roots)
+		r.push_back(to_logical(x)), write(GET_BDD_ID(r.back()), ids, v);
+	put(v.size() / 2);
+	for (bdd_ref x : v) put(x);
+	put(r.size());
+	for (bdd_ref x : r) {
+		if (GET_BDD_ID(x) > 1) SET_BDD_ID(x, ids.at(GET_BDD_ID(x)));
+		put(x);
+	}
+}
+
+/* Read BDDs written by write from the buffer from p to e, advancing p. A node
+ * already in V is found in the unique table and reused. Returns false if the
+ * buffer is short or refers to nodes not read yet. */
+
+bool bdd::read(const char*& p, const char* e, bdds& roots) {
+	auto get = [&p, e](uint64_t& x) {
+		if ((size_t) (e - p) < sizeof x) return false;
+		return memcpy(&x, p, sizeof x), p += sizeof x, true;
+	};
+	// The order of a node's children depends on their ids, so a node whose
+	// children got renumbered out of order is stored swapped and the input
+	// inverters of the references to it are flipped to keep V canonical.
+	vector<bdd_id> ids = { 0, 1 };
+	vector<bool> swp = { false, false };
+	auto local = [&ids, &swp](bdd_ref& y) {
+		const bdd_id x = GET_BDD_ID(y);
+		if (x >= ids.size()) return false;
+		if (swp[x]) y ^= uint64_t(1) << 62;
+		return SET_BDD_ID(y, ids[x]), true;
+	};
+	uint64_t n;
+	if (!get(n) || n > (uint64_t) (e - p) / (2 * sizeof n)) return false;
+	ids.reserve(n + 2), swp.reserve(n + 2), id_map.reserve(V.size() + n);
+	for (bdd_ref h, l; n--;) {
+		if (!get(h) || !get(l) || !local(h) || !local(l)) return false;
+		const bool s = BDD_LT(l, h);
+		if (s) swap(h, l);
+		bdd_id& id = id_map.at(h, l);
+		bdd_id r = id;
+		if (!r) r = id = new_node(h, l), id_map.added();
+		ids.push_back(r), swp.push_back(s);
+	}
+	if (!get(n) || n > (uint64_t) (e - p) / sizeof n) return false;
+	for (bdd_ref x; n--;)
+		if (!get(x) || !local(x)) return false;
+		else roots.push_back(to_physical(x));
+	return true;
+}
+
+void bdd_write(ostream& os, const bdd_handles& x) {
+	bdds r;
+	for (cr_spbdd_handle h : x) r.push_back(h->b);
+	bdd::write(os, r);
+}
+
+bool bdd_read(const char*& p, const char* e, bdd_handles& x) {
+	bdds r;
+	if (!bdd::read(p, e, r)) return false;
+	for (bdd_ref b : r) x.push_back(bdd_handle::get(b));
+	return true;
+}
+
 bdd_shft bdd_nvars(bdd_handles x) {
 	bdd_shft r = 0;
 	for (auto y : x) r = max(r, bdd_nvars(y));
 	return r;
 }
 
-bdd_shft bdd_nvars(spbdd_handle x) { return bdd::bdd_nvars(x->b); }
+bdd_shft bdd_nvars(spbdd_handle x) {
+	return bdd::bdd_nvars(bdd::to_logical(x->b));
+}
 bool leaf(cr_spbdd_handle h) { return bdd::leaf(h->b); }
 bool trueleaf(cr_spbdd_handle h) { return bdd::trueleaf(h->b); }
 template <typename T>
@@ -1052,7 +1787,7 @@ basic_ostream<T>& bdd::out(basic_ostream<T>& os, bdd_ref x) {
 
 void allsat_bin(cr_spbdd_handle x) {
 	bdd::t_pathv p;
-	bdd::allsat_bin_dump(x->b, p, 0);
+	bdd::allsat_bin_dump(bdd::to_logical(x->b), p, 0);
 }
 
 void bdd::allsat_bin_dump(bdd_ref x, t_pathv &p, size_t bit) {
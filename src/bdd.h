@@ -23,7 +23,9 @@
 #include <iostream>
 #include <memory>
 #include <functional>
+#include <chrono>
 #include <climits>
+#include <atomic>
 #include "defs.h"
 #ifndef NOMMAP
 #include "memory_map.h"
@@ -121,6 +123,98 @@ struct ite_memo {
 	bool operator==(const ite_memo& k) const{return x==k.x&&y==k.y&&z==k.z;}
 };
 
+/* A fixed-size lossy computed table for the results of ite/and in the style of
+ * CUDD. The table is 2-way set-associative with a power-of-two number of sets,
+ * each set being exactly one 64 byte cache line. A lookup probes a single set,
+ * an insertion into a full set evicts the older of its two entries. Entries
+ * whose x is 0 are empty since no operand ever references the dummy node.
+ * While shared is set the table is used by several threads at once: a set is
+ * guarded by one of a few striped spin locks that are only ever tried, so a
+ * contended lookup is a miss and a contended insertion is dropped. Hits and
+ * misses are not counted then. */
+
+class ite_cache {
+public:
+	struct entry { bdd_ref x, y, z, r; };
+	struct alignas(64) line { entry e[2]; };
+	ite_cache() { resize(sizeof(line) << 1); }
+	// Reallocates the table to the largest power-of-two number of sets that
+	// fits into the given number of bytes. All entries are dropped.
+	void resize(size_t bytes) {
+		size_t n = 2;
+		while ((n << 1) * sizeof(line) <= bytes) n <<= 1;
+		t.assign(n, line{}), sh = 64 - msb(n - 1), used = 0;
+	}
+	bool find(const ite_memo& m, bdd_ref& r) {
+		const size_t i = index(m);
+		if (shared && !lock(i)) return false;
+		bool f = false;
+		for (const entry& e : t[i].e)
+			if (e.x == m.x && e.y == m.y && e.z == m.z) {
+				r = e.r, f = true;
+				break;
+			}
+		if (shared) unlock(i);
+		else ++(f ? hits : misses);
+		return f;
+	}
+	void insert(const ite_memo& m, bdd_ref r) {
+		const size_t i = index(m);
+		if (shared && !lock(i)) return;
+		line& l = t[i];
+		if (l.e[0].x == m.x && l.e[0].y == m.y && l.e[0].z == m.z)
+			l.e[0].r = r;
+		else if (l.e[1].x == m.x && l.e[1].y == m.y && l.e[1].z == m.z)
+			l.e[1].r = r;
+		else {
+			if (!l.e[0].x || !l.e[1].x) count(used);
+			else count(evictions);
+			if (l.e[0].x) l.e[1] = l.e[0];
+			l.e[0] = { m.x, m.y, m.z, r };
+		}
+		if (shared) unlock(i);
+	}
+	// Calls f on every entry. Entries for which f returns false are dropped,
+	// the others are rehashed since f may have rewritten their references.
+	template <typename F> void remap(F f) {
+		std::vector<entry> keep;
+		for (line& l : t)
+			for (entry& e : l.e)
+				if (e.x && f(e)) keep.push_back(e);
+		clear();
+		for (const entry& e : keep) insert(ite_memo(e.x, e.y, e.z), e.r);
+	}
+	// Drops in place the entries for which f returns true.
+	template <typename F> void drop(F f) {
+		for (line& l : t) {
+			for (entry& e : l.e) if (e.x && f(e)) e = entry{}, --used;
+			if (!l.e[0].x) std::swap(l.e[0], l.e[1]);
+		}
+	}
+	void clear() { for (line& l : t) l = line{}; used = 0; }
+	size_t size() const { return used; }
+	size_t capacity() const { return t.size() << 1; }
+	size_t hits = 0, misses = 0, evictions = 0;
+	bool shared = false;
+private:
+	std::vector<line> t;
+	size_t sh = 63, used = 0;
+	std::atomic<bool> locks[4096] = {};
+	size_t index(const ite_memo& m) const {
+		return (m.hash * 0x9e3779b97f4a7c15ull) >> sh;
+	}
+	bool lock(size_t i) {
+		return !locks[i & 4095].exchange(true, std::memory_order_acquire);
+	}
+	void unlock(size_t i) {
+		locks[i & 4095].store(false, std::memory_order_release);
+	}
+	void count(size_t& c) {
+		if (shared) __atomic_fetch_add(&c, 1, __ATOMIC_RELAXED);
+		else ++c;
+	}
+};
+
 struct bdd_key {
 	uint_t hash;
 	bdd_ref h, l;
@@ -130,6 +224,108 @@ struct bdd_key {
 	bool operator==(const bdd_key& k) const { return h==k.h && l==k.l; }
 };
 
+/* A flat open-addressing unique table mapping a node definition (h,l) to its
+ * id in the node store v. Only ids are kept in the table, definitions are
+ * compared by looking them up in v and collisions are resolved by linear
+ * probing. Id 0 (the dummy node) marks an empty slot. Since the table holds no
+ * definitions it can be rebuilt by a single sweep over v once v is compacted. */
+
+template <typename N> class unique_table {
+public:
+	unique_table(const N& v) : v(v) { t.assign(16, 0), sh = 60; }
+	// Returns the slot holding the id of the node (h,l) or the empty slot
+	// where this id belongs. Filling the empty slot must be followed by a
+	// call to added().
+	bdd_id& at(bdd_ref h, bdd_ref l) {
+		for (size_t i = index(h, l);; i = (i + 1) & (t.size() - 1))
+			if (!t[i] || (v[t[i]].h == h && v[t[i]].l == l))
+				return t[i];
+	}
+	void added() { if (++n << 2 > t.size() * 3) rebuild(); }
+	// Lookup safe against a concurrent writer that fills empty slots with
+	// release stores while the table does not grow. Returns 0 if absent.
+	bdd_id find(bdd_ref h, bdd_ref l) const {
+		for (size_t i = index(h, l);; i = (i + 1) & (t.size() - 1)) {
+			const bdd_id id = __atomic_load_n(&t[i], __ATOMIC_ACQUIRE);
+			if (!id || (v[id].h == h && v[id].l == l)) return id;
+		}
+	}
+	// Whether one more node can be added without a rebuild.
+	bool room() const { return (n + 1) << 2 <= t.size() * 3; }
+	// Rebuilds the table if it cannot hold c nodes.
+	void reserve(size_t c) { if (c << 2 > t.size() * 3) rebuild(c); }
+	// Removes the node id, which has to be present, shifting back the slots
+	// following it so that no probe sequence is broken.
+	void erase(bdd_id id) {
+		size_t i = &at(v[id].h, v[id].l) - &t[0], j = i, k;
+		const size_t m = t.size() - 1;
+		while (t[j = (j + 1) & m]) {
+			k = index(v[t[j]].h, v[t[j]].l);
+			if (i <= j ? (k <= i || k > j) : (k <= i && k > j))
+				t[i] = t[j], i = j;
+		}
+		t[i] = 0, --n;
+	}
+	// Drops all slots and inserts every node of v, keeping load below 1/2
+	// for at least c nodes. Freed nodes, whose high part is the null
+	// reference, are skipped.
+	void rebuild(size_t c = 0) {
+		size_t k = 16;
+		while (k < std::max(c, v.size()) << 1) k <<= 1;
+		t.assign(k, 0), sh = 64 - msb(k - 1), n = 0;
+		for (bdd_id id = 1; id < v.size(); ++id)
+			if (v[id].h) at(v[id].h, v[id].l) = id, ++n;
+	}
+	size_t size() const { return n; }
+	size_t capacity() const { return t.size(); }
+private:
+	const N& v;
+	std::vector<bdd_id> t;
+	size_t sh, n = 0;
+	size_t index(bdd_ref h, bdd_ref l) const {
+		return (hash_upair(h, l) * 0x9e3779b97f4a7c15ull) >> sh;
+	}
+};
+
+/* A dense mark set holding one bit per node for the garbage collector. Once
+ * marking is done, index() computes per-word popcount prefix sums so that
+ * rank(n), the number of marked nodes before n and hence the id of n after
+ * compaction, takes a single popcount. */
+
+class bdd_marks {
+public:
+	void reset(size_t n) { w.assign((n + 63) >> 6, 0), r.clear(); }
+	bool marked(bdd_id n) const { return w[n >> 6] >> (n & 63) & 1; }
+	// Marks n and returns whether it was unmarked before.
+	bool insert(bdd_id n) {
+		const uint64_t b = uint64_t(1) << (n & 63);
+		return (w[n >> 6] & b) ? false : (w[n >> 6] |= b, true);
+	}
+	void index() {
+		r.resize(w.size());
+		for (size_t i = 0, c = 0; i != w.size(); ++i)
+			r[i] = c, c += __builtin_popcountll(w[i]);
+	}
+	bdd_id rank(bdd_id n) const {
+		return r[n >> 6] + __builtin_popcountll(w[n >> 6] &
+			((uint64_t(1) << (n & 63)) - 1));
+	}
+	size_t size() const {
+		size_t c = 0;
+		for (uint64_t x : w) c += __builtin_popcountll(x);
+		return c;
+	}
+	// Calls f on every marked node in increasing order.
+	template <typename F> void each(F f) const {
+		for (size_t i = 0; i != w.size(); ++i)
+			for (uint64_t x = w[i]; x; x &= x - 1)
+				f((i << 6) | __builtin_ctzll(x));
+	}
+	void clear() { w.clear(), r.clear(); }
+private:
+	std::vector<uint64_t> w, r;
+};
+
 template<> struct std::hash<bdd_key> {size_t operator()(const bdd_key&)const;};
 template<> struct std::hash<ite_memo>{size_t operator()(const ite_memo&)const;};
 template<> struct std::hash<std::array<int_t, 2>>{
@@ -141,11 +337,20 @@ template<> struct std::hash<std::array<bdd_ref, 2>>{
 
 const bdd_ref T = BDD_REF(1, 0, false, false), F = BDD_REF(1, 0, false, true);
 
+/* Garbage collection strategies of the BDD database. GC_COMPACT marks the nodes
+ * reachable from the live handles and compacts V, renumbering every node and
+ * rewriting all memos. GC_REFCOUNT keeps reference counts of the nodes, frees
+ * dead nodes into a free list reused by bdd::add and never moves a node. */
+enum gc_mode { GC_COMPACT, GC_REFCOUNT };
+
 spbdd_handle from_bit(bdd_shft b, bool v);
 
 spbdd_handle from_high(bdd_shft s, bdd_ref x);
 spbdd_handle from_low(bdd_shft s, bdd_ref y);
 spbdd_handle from_high_and_low(bdd_shft s, bdd_ref x, bdd_ref y);
+spbdd_handle from_sorted_paths(size_t n, bdd_shft nvars,
+	const std::function<bdd_shft(size_t)>& diff,
+	const std::function<bool(size_t, bdd_shft)>& bit);
 
 bool leaf(cr_spbdd_handle h);
 bool trueleaf(cr_spbdd_handle h);
@@ -187,8 +392,19 @@ extern size_t max_bdd_nodes;
 #ifndef NOMMAP
 extern mmap_mode bdd_mmap_mode;
 #endif
+// The work done so far: nodes created, and hits and misses of the computed
+// table and of the memos of the other operations
+struct bdd_stats {
+	size_t nodes, cache_hits, cache_misses, memo_hits, memo_misses;
+};
+bdd_stats bdd_get_stats();
+// If set, called after each garbage collection with its start and its pause
+extern std::function<void(std::chrono::steady_clock::time_point, double)>
+	bdd_gc_hook;
 
 void bdd_size(cr_spbdd_handle x, std::set<bdd_id>& s);
+// Number of distinct inner nodes
+size_t bdd_nodes(cr_spbdd_handle x);
 bdd_shft bdd_root(cr_spbdd_handle x);
 spbdd_handle bdd_not(cr_spbdd_handle x);
 spbdd_handle bdd_xor(cr_spbdd_handle x, cr_spbdd_handle y);
@@ -207,6 +423,38 @@ spbdd_handle bdd_quantify(cr_spbdd_handle x, const std::vector<quant_t> &quants,
 size_t satcount(cr_spbdd_handle x, const size_t bits);
 void allsat_bin(cr_spbdd_handle x);
 
+/* Unsigned integer of arbitrary precision, as much as model counts need. The
+ * 32-bit limbs are stored least significant first without leading zeros. */
+class big_uint {
+	std::vector<uint32_t> d;
+	void trim() { while (!d.empty() && !d.back()) d.pop_back(); }
+public:
+	big_uint(uint64_t x = 0) {
+		for (; x; x >>= 32) d.push_back((uint32_t) x);
+	}
+	static big_uint pow2(size_t k) { return big_uint(1) <<= k; }
+	big_uint& operator+=(const big_uint& x);
+	big_uint& operator-=(const big_uint& x);
+	big_uint& operator<<=(size_t k);
+	big_uint& operator>>=(size_t k);
+	bool operator==(const big_uint& x) const { return d == x.d; }
+	// The value, or the largest size_t if it does not fit
+	size_t get_size() const {
+		if (d.size() * 32 > sizeof(size_t) * 8) return size_t(-1);
+		size_t r = 0;
+		for (size_t n = d.size(); n--;) r = r << 16 << 16 | d[n];
+		return r;
+	}
+	std::string to_string() const;
+};
+
+template <typename T>
+std::basic_ostream<T>& operator<<(std::basic_ostream<T>& os, const big_uint& x);
+big_uint bdd_count(cr_spbdd_handle x, bdd_shft nvars);
+// Write BDDs into an image independent of V and read them back from one
+void bdd_write(std::ostream& os, const bdd_handles& x);
+bool bdd_read(const char*& p, const char* e, bdd_handles& x);
+
 /* A BDD is a pair of attributed references to BDDs. Separating out attributes
  * from BDDs increase the chances that BDDs can be reused in representing
  * different functions. */
@@ -214,6 +462,8 @@ void allsat_bin(cr_spbdd_handle x);
 class bdd {
 	friend class bdd_handle;
 	friend class allsat_cb;
+	friend class allcubes_cb;
+	template <typename N> friend class unique_table;
 	friend struct sbdd_and_many_ex;
 	friend struct sbdd_and_ex_perm;
 	friend struct sbdd_and_many_ex_perm;
@@ -251,6 +501,9 @@ class bdd {
 	friend spbdd_handle from_high(bdd_shft s, bdd_ref x);
 	friend spbdd_handle from_low(bdd_shft s, bdd_ref y);
 	friend spbdd_handle from_high_and_low(bdd_shft s, bdd_ref x, bdd_ref y);
+	friend spbdd_handle from_sorted_paths(size_t n, bdd_shft nvars,
+		const std::function<bdd_shft(size_t)>& diff,
+		const std::function<bool(size_t, bdd_shft)>& bit);
 	
 	friend bdd_shft bdd_nvars(spbdd_handle x);
 	friend bool leaf(cr_spbdd_handle h);
@@ -258,12 +511,15 @@ class bdd {
 	template <typename T>
 	friend std::basic_ostream<T>& out(std::basic_ostream<T>& os, cr_spbdd_handle x);
 	friend void bdd_size(cr_spbdd_handle x, std::set<bdd_id>& s);
+	friend size_t bdd_nodes(cr_spbdd_handle x);
 	friend bdd_shft bdd_root(cr_spbdd_handle x);
 	friend spbdd_handle bdd_not(cr_spbdd_handle x);
 	friend spbdd_handle bdd_xor(cr_spbdd_handle x, cr_spbdd_handle y);
 	friend spbdd_handle bdd_quantify(cr_spbdd_handle x, const std::vector<quant_t> &quants,
 			const size_t bits, const size_t n_args);
-	friend size_t satcount(cr_spbdd_handle x, const size_t bits);
+	friend big_uint bdd_count(cr_spbdd_handle x, bdd_shft nvars);
+	friend void bdd_write(std::ostream& os, const bdd_handles& x);
+	friend bool bdd_read(const char*& p, const char* e, bdd_handles& x);
 	friend void allsat_bin(cr_spbdd_handle x);
 	friend spbdd_handle bdd_bitwise_and(cr_spbdd_handle x, cr_spbdd_handle y);
 	friend spbdd_handle bdd_bitwise_or(cr_spbdd_handle x, cr_spbdd_handle y);
@@ -318,7 +574,15 @@ class bdd {
 		bdd_shft last, std::unordered_map<bdd_ref, bdd_ref>& memo);
 	static bdd_ref bdd_permute_ex(bdd_ref x, const bools& b, const bdd_shfts& m);
 	static bool solve(bdd_ref x, bdd_shft v, bdd_ref& l, bdd_ref& h);
-	static void mark_all(bdd_ref i);
+	static void mark_all();
+	static void gc_compact();
+	static void gc_refcount();
+	static size_t live_nodes();
+	template <typename F> static void rebind(F f);
+	static void swap_levels(bdd_shft k);
+	static size_t sift(bdd_shft v, size_t size);
+	static bdd_ref to_logical(bdd_ref x);
+	static bdd_ref to_physical(bdd_ref x);
 	static size_t bdd_and_many_iter(bdds, bdds&, bdds&, bdd_ref&, bdd_shft&);
 	static char bdd_and_many_ex_iter(const bdds&v, bdds& h, bdds& l,
 		bdd_shft &m);
@@ -330,10 +594,16 @@ class bdd {
 	static void bdd_sz(bdd_ref x, std::set<bdd_ref>& s);
 	static void bdd_nvars(bdd_ref x, std::set<bdd_shft>& s);
 	static bdd_shft bdd_nvars(bdd_ref x);
+	static const std::pair<bdd_shft, big_uint>& bdd_count(bdd_id x,
+		std::unordered_map<bdd_id, std::pair<bdd_shft, big_uint>>& memo);
+	static big_uint bdd_count(bdd_ref x, bdd_shft nvars);
+	static void write(bdd_id x, std::unordered_map<bdd_id, bdd_id>& ids,
+		bdds& v);
+	static void write(std::ostream& os, const bdds& roots);
+	static bool read(const char*& p, const char* e, bdds& roots);
 	static bool bdd_subsumes(bdd_ref x, bdd_ref y);
 	static bdd_ref add(bdd_shft v, bdd_ref h, bdd_ref l);
 	inline static bdd_ref from_bit(bdd_shft b, bool v);
-	inline static void max_bdd_size_check();
 	inline static bool leaf(bdd_ref t) { return BDD_ABS(t) == T; }
 	inline static bool trueleaf(bdd_ref t) { return !GET_INV_OUT(t); }
 	template <typename T>
@@ -347,6 +617,7 @@ class bdd {
 	//---
 #ifndef NOBDDARITH
 	static void bdd_sz_abs(bdd_ref x, std::set<bdd_id>& s);
+	static size_t bdd_nodes(bdd_ref x);
 	static bdd_ref bdd_xor(bdd_ref x, bdd_ref y);
 	static bdd_ref bdd_quantify(bdd_ref x, uint_t bit, const std::vector<quant_t> &quants,
 			const size_t bits, const size_t n_args);
@@ -375,7 +646,6 @@ class bdd {
 			t_pathv &path_a, t_pathv &path_b, t_pathv &pathX_a, t_pathv &pathX_b);
 	static bdd_ref merge_pathX(size_t i, size_t bits, bool carry, size_t n_args, size_t depth,
 			t_pathv &path_a, t_pathv &path_b, t_pathv &pathX_a, t_pathv &pathX_b);
-	static void satcount_arith(bdd_ref a_in, size_t bit, size_t bits, size_t factor, size_t &count);
 	static bdd_ref zero(size_t arg, size_t bits, size_t n_args);
 	static bool is_zero(bdd_ref a_in, size_t bits);
 	static void adder_be(bdd_ref a_in, bdd_ref b_in, size_t bits, size_t depth,
@@ -396,7 +666,7 @@ public:
 	}
 #ifndef NOMMAP
 	static void init(mmap_mode m = MMAP_NONE, size_t max_size=10000,
-		const std::string fn="");
+		const std::string fn="", bool huge = false);
 #else
 	static void init();
 #endif
@@ -404,8 +674,13 @@ public:
 	template <typename T>
 	static std::basic_ostream<T>& stats(std::basic_ostream<T>& os);
 	static size_t get_ite_cache_size();
+	static void set_ite_cache_size(size_t new_ite_cache_bytes);
 	static void set_gc_limit(size_t new_gc_limit);
 	static void set_gc_enabled(bool new_gc_enabled);
+	static void set_gc_mode(gc_mode new_gc_mode);
+	static void set_threads(size_t new_threads);
+	static void set_reorder_limit(size_t new_reorder_limit);
+	static void reorder();
 
 	/* Return the absolute BDD corresponding to the high part of the given BDD
 	 * reference. If x represents a boolean function f, then this function returns
@@ -437,23 +712,39 @@ public:
 class bdd_handle {
 	friend class bdd;
 	bdd_handle(bdd_ref b) : b(b) { }
-	static void update(const std::vector<bdd_id>& p);
+	static void update();
 	static std::unordered_map<bdd_ref, std::weak_ptr<bdd_handle>> M;
 public:
 	bdd_ref b;
 	static spbdd_handle get(bdd_ref b);
 	static spbdd_handle T, F;
-	~bdd_handle() {
-		if (onexit) return;
-		if (GET_BDD_ID(b) > 1) M.erase(b);
-	}
+	~bdd_handle();
 };
 
 class allsat_cb {
 public:
 	typedef std::function<void(const bools&, bdd_ref)> callback;
 	allsat_cb(cr_spbdd_handle r, bdd_shft nvars, callback f) :
-		r(r->b), nvars(nvars), f(f), p(nvars) {}
+		r(bdd::to_logical(r->b)), nvars(nvars), f(f), p(nvars) {}
+	void operator()() { sat(r); }
+private:
+	bdd_ref r;
+	const bdd_shft nvars;
+	bdd_shft v = 1;
+	callback f;
+	bools p;
+	void sat(bdd_ref x);
+};
+
+/* Enumerates the cubes of a BDD, its paths to true. A cube is given by the
+ * values of its variables and by the increasing list of the variables it leaves
+ * free, these being reported as false. Unlike allsat_cb it does not branch on
+ * the free variables, so a cube stands for many assignments. */
+class allcubes_cb {
+public:
+	typedef std::function<void(const bools&, const bdd_shfts&)> callback;
+	allcubes_cb(cr_spbdd_handle r, bdd_shft nvars, callback f) :
+		r(bdd::to_logical(r->b)), nvars(nvars), f(f), p(nvars) {}
 	void operator()() { sat(r); }
 private:
 	bdd_ref r;
@@ -461,6 +752,7 @@ private:
 	bdd_shft v = 1;
 	callback f;
 	bools p;
+	bdd_shfts dc;
 	void sat(bdd_ref x);
 };
 
@@ -20,17 +20,22 @@ using namespace std;
 //------------------------------------------------------------------------------
 // auxiliary functions
 bdd_shft bdd_root(cr_spbdd_handle x) {
-	return (bdd::var(x->b));
+	return (bdd::var(bdd::to_logical(x->b)));
 }
 
 void bdd_size(cr_spbdd_handle x, std::set<bdd_id>& s) {
 	bdd::bdd_sz_abs(x->b, s);
 }
 
+size_t bdd_nodes(cr_spbdd_handle x) {
+	return bdd::bdd_nodes(x->b);
+}
+
 //------------------------------------------------------------------------------
 spbdd_handle bdd_quantify(cr_spbdd_handle x, const std::vector<quant_t> &quants,
 		const size_t bits, const size_t n_args) {
-	return bdd_handle::get(bdd::bdd_quantify(x->b, 0, quants, bits, n_args));
+	return bdd_handle::get(bdd::to_physical(bdd::bdd_quantify(
+		bdd::to_logical(x->b), 0, quants, bits, n_args)));
 }
 
 spbdd_handle bdd_not(cr_spbdd_handle x) {
@@ -38,40 +43,41 @@ spbdd_handle bdd_not(cr_spbdd_handle x) {
 }
 
 size_t satcount(cr_spbdd_handle x, const size_t bits) {
-	bdd_shft av = GET_SHIFT(x->b);
-	size_t cnt = 0;
-	size_t factor = x->b != T ? pow(2,av-1) : 1;
-	size_t bit = (x->b != T && x->b != F) ? (av)-1 : 0;
-	bdd::satcount_arith(x->b, bit, bits, factor, cnt);
-	return cnt;
+	return bdd_count(x, bits).get_size();
 }
 
 //------------------------------------------------------------------------------
 //over bdd bitwise operators
 spbdd_handle bdd_bitwise_and(cr_spbdd_handle x, cr_spbdd_handle y) {
-	return bdd_handle::get(bdd::bitwise_and(x->b,y->b));
+	return bdd_handle::get(bdd::to_physical(
+		bdd::bitwise_and(bdd::to_logical(x->b), bdd::to_logical(y->b))));
 }
 
 spbdd_handle bdd_bitwise_or(cr_spbdd_handle x, cr_spbdd_handle y) {
-	return bdd_handle::get(bdd::bitwise_or(x->b,y->b));
+	return bdd_handle::get(bdd::to_physical(
+		bdd::bitwise_or(bdd::to_logical(x->b), bdd::to_logical(y->b))));
 }
 
 spbdd_handle bdd_bitwise_xor(cr_spbdd_handle x, cr_spbdd_handle y) {
-	return bdd_handle::get(bdd::bitwise_xor(x->b,y->b));
+	return bdd_handle::get(bdd::to_physical(
+		bdd::bitwise_xor(bdd::to_logical(x->b), bdd::to_logical(y->b))));
 }
 
 spbdd_handle bdd_bitwise_not(cr_spbdd_handle x) {
-	return bdd_handle::get(bdd::bitwise_not(x->b));
+	return bdd_handle::get(
+		bdd::to_physical(bdd::bitwise_not(bdd::to_logical(x->b))));
 }
 
 // over bdd arithmetic
 spbdd_handle bdd_leq(cr_spbdd_handle x, cr_spbdd_handle y,
 		const size_t x_bitw, const size_t y_bitw) {
-	return bdd_handle::get(bdd::leq(x->b,y->b, 0, x_bitw, y_bitw));
+	return bdd_handle::get(bdd::to_physical(bdd::leq(bdd::to_logical(x->b),
+		bdd::to_logical(y->b), 0, x_bitw, y_bitw)));
 }
 
 spbdd_handle bdd_adder(cr_spbdd_handle x, cr_spbdd_handle y) {
-	return bdd_handle::get(bdd::adder(x->b,y->b, false, 0));
+	return bdd_handle::get(bdd::to_physical(bdd::adder(
+		bdd::to_logical(x->b), bdd::to_logical(y->b), false, 0)));
 }
 
 spbdd_handle bdd_mult_dfs(cr_spbdd_handle x, cr_spbdd_handle y, size_t bits,
@@ -79,7 +85,8 @@ spbdd_handle bdd_mult_dfs(cr_spbdd_handle x, cr_spbdd_handle y, size_t bits,
 	//bdds
 	bdd_ref *z_aux = new bdd_ref[bits];
 	bdd_ref c = F;
-	bdd::mult_dfs(x->b, y->b, z_aux, 0, bits, n_vars, c);
+	bdd::mult_dfs(bdd::to_logical(x->b), bdd::to_logical(y->b), z_aux, 0,
+		bits, n_vars, c);
 	delete[] z_aux;
 	size_t ext_bits = 2*bits;
 	bools exvec;
@@ -89,7 +96,7 @@ spbdd_handle bdd_mult_dfs(cr_spbdd_handle x, cr_spbdd_handle y, size_t bits,
 		else exvec.push_back(false);
 	}
 	c = bdd::bdd_ex(c, exvec);
-	return bdd_handle::get(c);
+	return bdd_handle::get(bdd::to_physical(c));
 }
 
 // ----------------------------------------------------------------------------
@@ -136,25 +143,6 @@ bdd_ref bdd::bdd_quantify(bdd_ref x, uint_t bit, const std::vector<quant_t> &qua
 	return F;
 }
 
-void bdd::satcount_arith(bdd_ref a, size_t bit, size_t bits, size_t factor,
-		size_t &count) {
-	bdd ab = bdd::get(a);
-	bdd_shft av = GET_SHIFT(a);
-	if (ab.h == F && ab.l == F) return;
-	if (ab.h == T && ab.l == T) {
-		count = count + factor * pow(2, bits-bit); return;
-	}
-	if (ab.h != F) {
-		size_t delta = ab.h != T ? pow(2, GET_SHIFT(ab.h) - av - 1) : 1;
-		satcount_arith(ab.h, av, bits, factor * delta, count);
-	}
-	if (ab.l != F) {
-		size_t delta = ab.l != T ? pow(2, GET_SHIFT(ab.l) - av - 1) : 1;
-		satcount_arith(ab.l, av, bits, factor * delta, count);
-	}
-	return;
-}
-
 bdd_ref bdd::leq(bdd_ref a_in, bdd_ref b_in, size_t bit, const size_t x_bitw,
 		const size_t y_bitw) {
 
@@ -196,6 +184,16 @@ void bdd::bdd_sz_abs(bdd_ref x, set<bdd_id>& s) {
 	bdd_sz_abs(b.h, s), bdd_sz_abs(b.l, s);
 }
 
+size_t bdd::bdd_nodes(bdd_ref x) {
+	unordered_set<bdd_id> s;
+	vector<bdd_id> st = { GET_BDD_ID(x) };
+	for (bdd_id n; !st.empty();)
+		if (n = st.back(), st.pop_back(), n > 1 && s.insert(n).second)
+			st.push_back(GET_BDD_ID(V[n].h)),
+			st.push_back(GET_BDD_ID(V[n].l));
+	return s.size();
+}
+
 bdd_ref bdd::bitwise_and(bdd_ref a_in, bdd_ref b_in) {
 	bdd a = bdd::get(a_in), b = bdd::get(b_in);
 	if (a_in == T && b_in == T) return T;
@@ -1079,5 +1077,6 @@ spbdd_handle bdd_xor(cr_spbdd_handle x, cr_spbdd_handle y) {
 }
 
 spbdd_handle bdd_shift(cr_spbdd_handle x, bdd_shft amt) {
-	return bdd_handle::get(bdd::bdd_shift(x->b, amt));
+	return bdd_handle::get(
+		bdd::to_physical(bdd::bdd_shift(bdd::to_logical(x->b), amt)));
 }
@@ -116,7 +116,9 @@ enum proof_mode { none, tree, forest, partial_tree, partial_forest };
 typedef struct {
 	bool optimize, print_transformed, apply_regexpmatch, fp_step,
 		show_hidden, bin_lr, incr_gen_forest,
-		binarize = true, print_binarized = false; //needed default values
+		binarize = true, print_binarized = false, //needed default values
+		semi_naive = false, stratify = false, bounded_fronts = false,
+		quantify_early = false, profile = false, leo = true;
 
 	enum proof_mode bproof;
 	size_t bitorder;
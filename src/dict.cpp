@@ -19,37 +19,62 @@
 
 using namespace std;
 
+/* The slot of l, of hash h, or the empty one where it would go. The table
+ * is never full, as it grows at half of its size. */
+
+size_t lexmap::slot(const lexeme& l, size_t h) const {
+	const size_t m = t.size() - 1, len = l[1] - l[0];
+	for (size_t k = h & m;; k = (k + 1) & m)
+		if (!t[k].l[0] || (t[k].h == h && (size_t) (t[k].l[1] -
+			t[k].l[0]) == len && !memcmp(t[k].l[0], l[0], len)))
+			return k;
+}
+
+const lexmap::entry* lexmap::find(const lexeme& l, size_t h) const {
+	if (t.empty()) return nullptr;
+	const entry& e = t[slot(l, h)];
+	return e.l[0] ? &e : nullptr;
+}
+
+int_t lexmap::emplace(const lexeme& l, size_t h, int_t id) {
+	DBG(assert(l[0]);)
+	if ((n + 1) * 2 > t.size()) {
+		vector<entry> o(max(t.size() * 2, (size_t) 16),
+			entry{ { nullptr, nullptr }, 0, 0 });
+		swap(t, o);
+		for (const entry& e : o) if (e.l[0]) t[slot(e.l, e.h)] = e;
+	}
+	entry& e = t[slot(l, h)];
+	if (e.l[0]) return e.id;
+	return ++n, e = { l, h, id }, id;
+}
+
 dict_t::dict_t() {}
-dict_t::~dict_t() { for (auto x : strs_allocated) free((char *)x); }
+dict_t::~dict_t() {}
 
 int_t dict_t::get_var(const lexeme& l) {
-	auto it = vars_dict.find(l);
-	if (it != vars_dict.end()) return it->second;
-	int_t r = -vars_dict.size() - 1;
-	vars.push_back(l);
-	return vars_dict[l] = r;
+	const int_t r = vars_dict.emplace(l, -(int_t) vars.size() - 1);
+	if (r == -(int_t) vars.size() - 1) vars.push_back(l);
+	return r;
 }
 
 int_t dict_t::get_rel(const lexeme& l) {
-	auto it = rels_dict.find(l);
-	if (it != rels_dict.end()) return it->second;
-	rels.push_back(l);
-	return rels_dict[l] = rels.size() - 1;
+	const int_t r = rels_dict.emplace(l, rels.size());
+	if (r == (int_t) rels.size()) rels.push_back(l);
+	return r;
 }
 
 int_t dict_t::get_sym(const lexeme& l) {
-	auto it = syms_dict.find(l);
-	if (it != syms_dict.end()) return it->second;
-	syms.push_back(l);
-	return syms_dict[l] = syms.size()-1;
+	const int_t r = syms_dict.emplace(l, syms.size());
+	if (r == (int_t) syms.size()) syms.push_back(l);
+	return r;
 }
 
 int_t dict_t::get_bltin(const lexeme& l) {
 	if (*l[0] == '?') parse_error(err_var_relsym, l);
-	auto it = bltins_dict.find(l);
-	if (it != bltins_dict.end()) return it->second;
-	bltins.push_back(l);
-	return bltins_dict[l] = bltins.size() - 1;
+	const int_t r = bltins_dict.emplace(l, bltins.size());
+	if (r == (int_t) bltins.size()) bltins.push_back(l);
+	return r;
 }
 
 int_t dict_t::get_new_sym() {
@@ -85,14 +110,18 @@ ints dict_t::get_rels(function<bool(const lexeme&)> filter) {
 }
 
 lexeme dict_t::get_lexeme(ccs w, size_t l) {
+	static const size_t block = 1 << 16;
 	if (l == (size_t)-1) l = strlen(w);
-	auto it = strs_extra.find({ w, w + l });
-	if (it != strs_extra.end()) return *it;
-	cstr r = strdup(w);
-	strs_allocated.push_back(r);
-	lexeme lx = { r, r + l };
-	strs_extra.insert(lx);
-	return lx;
+	const size_t h = lexmap::hash({ w, w + l });
+	if (auto e = strs.find({ w, w + l }, h)) return e->l;
+	if ((size_t) (free_e - free_p) <= l) {
+		const size_t n = max(block, l + 1);
+		blocks.emplace_back(new char_t[n]);
+		free_p = blocks.back().get(), free_e = free_p + n;
+	}
+	lexeme lx = { free_p, free_p + l };
+	memcpy(free_p, w, l), free_p[l] = 0, free_p += l + 1;
+	return strs.emplace(lx, h, 0), lx;
 }
 lexeme dict_t::get_lexeme(const std::basic_string<unsigned char>& s) {
 	ccs w = s.c_str();
@@ -106,9 +135,9 @@ lexeme dict_t::get_lexeme(const std::basic_string<char>& s) {
 //---
 
 int_t dict_t::get_temp_sym(const lexeme& l) {
-	auto it = temp_syms_dict.find(l);
-	if (it != temp_syms_dict.end()) return it->second;
-	return temp_syms.push_back(l), temp_syms_dict[l] = (temp_syms.size());
+	const int_t r = temp_syms_dict.emplace(l, temp_syms.size() + 1);
+	if (r == (int_t) temp_syms.size() + 1) temp_syms.push_back(l);
+	return r;
 }
 
 int_t dict_t::get_fresh_temp_sym() {
@@ -16,17 +16,52 @@
 
 #include "defs.h"
 #include <map>
+#include <memory>
 #include <functional>
+#include <string_view>
+
+/* Ids of lexemes, compared by their characters, in an open addressing hash
+ * table. The hash of each lexeme is kept with it, so probes compare the
+ * characters only on equal hashes and growing does not hash again. */
+
+class lexmap {
+public:
+	struct entry {
+		lexeme l;
+		size_t h;
+		int_t id;
+	};
+	static size_t hash(const lexeme& l) {
+		return std::hash<std::string_view>()(std::string_view(
+			(const char*) l[0], l[1] - l[0]));
+	}
+	const entry* find(const lexeme& l, size_t h) const;
+	const entry* find(const lexeme& l) const { return find(l, hash(l)); }
+	// The id of l, which gets the given one if l is new
+	int_t emplace(const lexeme& l, size_t h, int_t id);
+	int_t emplace(const lexeme& l, int_t id) {
+		return emplace(l, hash(l), id);
+	}
+	bool contains(const lexeme& l) const { return find(l); }
+	size_t size() const { return n; }
+private:
+	// Empty entries have a null lexeme
+	std::vector<entry> t;
+	size_t n = 0;
+	size_t slot(const lexeme& l, size_t h) const;
+};
 
 class inputs;
 class dict_t {
 	
-	typedef std::map<lexeme, int_t, lexcmp> dictmap;
+	typedef lexmap dictmap;
 	dictmap syms_dict, vars_dict, rels_dict, temp_syms_dict, bltins_dict;
 	std::vector<lexeme> syms, vars, rels, temp_syms, bltins;
 
-	std::set<lexeme, lexcmp> strs_extra;
-	std::vector<ccs> strs_allocated;
+	// The strings of get_lexeme, allocated from blocks which never move
+	dictmap strs;
+	std::vector<std::unique_ptr<char_t[]>> blocks;
+	char_t *free_p = nullptr, *free_e = nullptr;
 	inputs* ii = nullptr;
 public:
 
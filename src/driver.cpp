@@ -26,6 +26,9 @@
 #include <numeric>
 #include <optional>
 #include <ranges>
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <sys/resource.h>
+#endif
 
 #include "driver.h"
 #include "err.h"
@@ -2133,6 +2136,68 @@ bool driver::run(size_t steps, size_t break_on_step) {
 
 // ----------------------------------------------------------------------------
 
+/* Add the given facts to the program, or retract them from it, along with
+ * their consequences in the database. The database is updated incrementally
+ * when it holds the fixpoint of a monotone program. Otherwise it is emptied
+ * for the program to run anew and false is returned, as on errors. */
+
+bool driver::add_facts(const string& src) { return update_facts(src, false); }
+bool driver::retract_facts(const string& src) {
+	return update_facts(src, true);
+}
+
+bool driver::update_facts(const string& src, bool retract) {
+	raw_progs rps(dict);
+	if (!rps.parse(dynii.add_string(src)) || rps.p.nps.empty())
+		return !(error = true);
+	raw_prog& fp = rps.p.nps[0];
+	auto is_fact = [](const raw_rule& r) {
+		return r.type == raw_rule::NONE && r.b.empty() && !r.prft &&
+			all_of(r.h.begin(), r.h.end(), [](const raw_term& t) {
+				return t.extype == raw_term::REL && !t.neg &&
+					none_of(t.e.begin(), t.e.end(), [](const elem& e) {
+						return e.type == elem::VAR; }); });
+	};
+	if (fp.r.empty() || !fp.nps.empty() || !fp.d.empty() ||
+		!fp.g.empty() || !all_of(fp.r.begin(), fp.r.end(), is_fact))
+		return o::err() << err_facts_only << endl, !(error = true);
+	if (rp.p.nps.empty()) rp.p.nps.emplace_back(dict);
+	raw_prog& p = rp.p.nps[0];
+	if (!retract) p.r.insert(p.r.end(), fp.r.begin(), fp.r.end());
+	else {
+		auto str = [](const raw_term& t) {
+			ostringstream ss;
+			return ss << t, ss.str();
+		};
+		set<string> ts;
+		for (const raw_rule& r : fp.r)
+			for (const raw_term& t : r.h) ts.insert(str(t));
+		for (raw_rule& r : p.r)
+			if (is_fact(r)) r.h.erase(remove_if(r.h.begin(), r.h.end(),
+				[&](const raw_term& t) {
+					return ts.find(str(t)) != ts.end(); }), r.h.end());
+		p.r.erase(remove_if(p.r.begin(), p.r.end(), [](const raw_rule& r) {
+			return r.h.empty(); }), p.r.end());
+	}
+	if (!tbl) return false;
+	bool incr = result && !error && p.nps.empty() &&
+		tbl->prog_after_fp.empty() && !opts.enabled("guards") &&
+		tbl->is_monotone();
+	flat_prog m;
+	if (incr) m = ir->to_terms(fp), ir->syms = dict.nsyms();
+	// New symbols may need another bit, and then a full run
+#if defined(BIT_TRANSFORM) | defined(BIT_TRANSFORM_V2) | defined(TYPE_RESOLUTION)
+	incr = false;
+#else
+	incr = incr && max(max(ir->nums, ir->chars), ir->syms) <
+		(1 << (tbl->bits - 2));
+#endif
+	if (!incr) return tbl->clear_tables(), running = false, false;
+	tables_progress tp(dict, *ir);
+	result = retract ? tbl->retract_facts(m, tp) : tbl->add_facts(m, tp);
+	if (tbl->error) error = true;
+	return result;
+}
 bool driver::add(input* in) {
 	//TODO: handle earlier errors on the input arguments
 	if (opts.enabled("earley")) {
@@ -2179,6 +2244,7 @@ bool driver::add_prog_wprod(flat_prog m, const vector<production>& g/*, bool mkn
 	if (tbls.populate_tml_update) init_tml_update(updts);
 
 	tbls.rules.clear(), tbls.datalog = true;
+	if (tbls.prof) tbls.prof->clear_rules();
 
 	// TODO this call must be done in the driver
 	if (!ir_handler.transform_grammar(g, m)) return false;
@@ -2308,11 +2374,11 @@ bool driver::run_prog(const raw_prog& p, const strs_t& strs_in, size_t steps,
 	bool r = true;
 	// run program only if there are any rules
 	if (tbls.rules.size()) {
-		tbls.fronts.clear();
+		tbls.clear_fronts();
 		r = tbls.pfp(steps ? tbls.nstep + steps : 0, break_on_step, ps);
 	} else {
 		bdd_handles l = tbls.get_front();
-		tbls.fronts = {l, l};
+		tbls.clear_fronts(), tbls.add_front(l), tbls.add_front(l);
 	}
 	//----------------------------------------------------------
 	//TODO: prog_after_fp is required for grammar/str recognition,
@@ -2395,10 +2461,16 @@ driver::driver(string s, const options &o) : dict(dict_t()), opts(o), rp(raw_pro
 	to.print_transformed = opts.enabled("t");
 	to.apply_regexpmatch = opts.enabled("regex");
 	to.fp_step           = opts.enabled("fp");
+	to.semi_naive        = opts.enabled("semi-naive");
+	to.stratify          = opts.enabled("stratify");
+	to.bounded_fronts    = opts.enabled("bounded-fronts");
+	to.quantify_early    = opts.enabled("quantify-early");
+	to.profile           = opts.enabled("profile");
 	to.show_hidden       = opts.enabled("show-hidden");
 	to.bin_lr            = opts.enabled("bin-lr");
 	to.bitorder          = opts.get_int("bitorder");
 	to.incr_gen_forest	 = opts.enabled("incr-gen-forest");
+	to.leo               = opts.enabled("leo");
 
 	ir = new ir_builder(dict, to);
 	builtins_factory* bf = new builtins_factory(dict, *ir);
@@ -2411,6 +2483,16 @@ driver::driver(string s, const options &o) : dict(dict_t()), opts(o), rp(raw_pro
 
 	ir->dynenv  = tbl;
 	ir->printer = tbl;
+	if (tbl->prof) tbl->prof->rule_name = [this](size_t n) {
+		ostringstream ss;
+		return print(ss, tbl->rules[n]), ss.str();
+	};
+	if (opts.enabled("load-db") && !load_db(opts.get_string("load-db"))) {
+		error = true;
+		return;
+	}
+	for (const string& l : opts.loads)
+		if (!load_facts(l)) { error = true; return; }
 
 	// TODO move this options to rt_options
 	set_print_step(opts.enabled("ps"));
@@ -2456,6 +2538,7 @@ driver::driver(ccs s)                           : driver(string_t(s)) {}
 driver::~driver() {
 	if (tbl) delete tbl;
 	if (ir) delete ir;
+	for (auto p : tml_parser) if (p) delete p;
 }
 // ----------------------------------------------------------------------------
 template <typename T>
@@ -2471,6 +2554,19 @@ void driver::info(std::basic_ostream<T>& os) {
 		<< (nsteps() - pd.start_step) << " ("
 		<< (running ? "" : "not ") << "running)" << endl;
 	bdd::stats(os<<"# bdds:     \t")<<endl;
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	struct rusage ru;
+	if (!getrusage(RUSAGE_SELF, &ru))
+		os << "# memory:    \tpeak rss: " << ru.ru_maxrss << " kB" << endl;
+#endif
+	if (!tbl) return;
+	for (ntable n = 0; n != (ntable)tbl->tbls.size(); ++n) {
+		const table& t = tbl->tbls[n];
+		if (t.is_builtin() || (t.hidden && !rt_opts.show_hidden))
+			continue;
+		os << "# table:     \t" << dict.get_rel_lexeme(get<0>(t.s)) <<
+			'/' << t.len << " tuples: " << tbl->cardinality(n) << endl;
+	}
 }
 template void driver::info(std::basic_ostream<char>&);
 template void driver::info(std::basic_ostream<wchar_t>&);
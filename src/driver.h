@@ -89,6 +89,7 @@ elem rename_variables(const elem &e, std::map<elem, elem> &renames,
 void rename_variables(raw_form_tree &t, std::map<elem, elem> &renames,
 	const std::function<elem (const elem &)> &gen);
 
+template <typename CharT> class earley;
 
 class driver {
 	friend struct flat_rules;
@@ -190,6 +191,8 @@ private:
 	std::set<lexeme> transformed_strings;
 	tables *tbl = 0;
 	ir_builder *ir = 0;
+	// the TML grammar compiled once for each of -bin-lr and reused
+	earley<char32_t> *tml_parser[2] = { 0, 0 };
 
 	std::set<lexeme> vars;
 	options opts;
@@ -205,6 +208,7 @@ private:
 	bool add_bdd_builtins(builtins& bltins);
 	bool add_print_builtins(builtins& bltins);
 	bool add_js_builtins(builtins& bltins);
+	bool update_facts(const std::string& src, bool retract);
 
 
 
@@ -249,7 +253,7 @@ public:
 	template <typename T>
 	void out_result(std::basic_ostream<T> &os);
 	template <typename T>
-	void out(std::basic_ostream<T> &os) { print_dict(os); }
+	void out(std::basic_ostream<T> &os) { print_dict(os), out_result(os); }
 
 	void init_tml_update(updates& updts);
 
@@ -293,6 +297,8 @@ public:
 	void restart();
 	bool step(size_t steps = 1, size_t br_on_step=0);
 	bool run(size_t steps = 0, size_t br_on_step=0);
+	bool add_facts(const std::string& src);
+	bool retract_facts(const std::string& src);
 	size_t nsteps() { return tbl->step(); };
 
 	void set_print_step   (bool val) { tbl->print_steps   = val; }
@@ -315,6 +321,10 @@ public:
 	void dump() { 
 	}
 	void save_csv() const;
+	bool save_db(const std::string& fn) const;
+	bool load_db(const std::string& fn);
+	bool load_facts(const std::string& spec);
+	bool save_profile(const std::string& fn) const;
 	
 #ifdef __EMSCRIPTEN__
 	void out(emscripten::val o) const { if (tbl) tbl->out(o); }
@@ -141,6 +141,7 @@ earley<CharT>::earley(const vector<production> &g, const char_builtins_map& bm,
 			if (all_nulls(p))
 				nullables.insert(p[0].n());
 	} while (k != nullables.size());
+	compile();
 #ifdef DEBUG
 	o::dbg() << endl << "grammar begin" << endl;
 	for (auto x : G) {
@@ -205,6 +206,7 @@ earley<CharT>::earley(const vector<pair<string, vector<vector<string>>>>& g,
 		for (const auto& p : G)
 			if (all_nulls(p)) nullables.insert(p[0].n());
 	} while (k != nullables.size());
+	compile();
 #ifdef DEBUG
 	o::dbg() << "g: \n";
 	for (auto x : g)
@@ -225,11 +227,66 @@ earley<CharT>::earley(const vector<pair<string, vector<vector<string>>>>& g,
 #endif
 }
 
+// numbers the dotted rules of the production
+template <typename CharT>
+void earley<CharT>::compile(size_t prod) {
+	dr.push_back(nulls.size());
+	for (const lit& l : G[prod])
+		nulls.push_back(l.nt() ? nullables.count(l.n()) > 0
+			: l.c() == (CharT) '\0');
+	nulls.push_back(false);
+}
+
+// precomputes the nonterminals which predicting each one predicts
+template <typename CharT>
+void earley<CharT>::compile() {
+	dr.clear(), nulls.clear();
+	for (size_t p = 0; p != G.size(); ++p) compile(p);
+	nt_prods.assign(d.v.size(), {}), closure.assign(d.v.size(), {});
+	predicted.assign(d.v.size(), 0);
+	for (size_t p = 0; p != G.size(); ++p)
+		nt_prods[G[p][0].n()].push_back(p);
+	for (size_t n = 0; n != closure.size(); ++n) {
+		vector<bool> done(closure.size());
+		auto& c = closure[n];
+		c.push_back(n), done[n] = true;
+		for (size_t k = 0; k != c.size(); ++k)
+			for (size_t p : nt_prods[c[k]])
+				// the symbols up to the first one not nullable
+				for (size_t dot = 1; dot != G[p].size(); ++dot) {
+					const lit& l = G[p][dot];
+					if (l.nt() && !l.is_builtin() && !done[l.n()])
+						c.push_back(l.n()), done[l.n()] = true;
+					if (!nulls[dr[p] + dot]) break;
+				}
+	}
+}
+
+// stores the packs of the node with its children interned
+template <typename CharT>
+void earley<CharT>::parse_forest_t::set(size_t id,
+	const std::set<std::vector<nidx_t>>& ambset)
+{
+	build(id), np[id] = { packs.size(), ambset.size() };
+	for (auto& pack : ambset) {
+		packs.emplace_back(kids.size(), pack.size());
+		for (const nidx_t& n : pack) kids.push_back(get(n));
+	}
+}
+
+template <typename CharT>
+vector<size_t> earley<CharT>::parse_forest_t::sorted() const {
+	vector<size_t> v(built);
+	sort(v.begin(), v.end(), [this](size_t x, size_t y) {
+		return nodes[x] < nodes[y]; });
+	return v;
+}
+
 template <typename CharT>
 typename earley<CharT>::ostream& earley<CharT>::print(
 	earley<CharT>::ostream& os, const item& i) const
 {
-	put(put(os, i.set) << " ", i.from) << " ";
+	put(put(os, (size_t) i.set) << " ", (size_t) i.from) << " ";
 	for (size_t n = 0; n != G[i.prod].size(); ++n) {
 		if (n == i.dot) os << "* ";
 		if (G[i.prod][n].nt()) put(os, d.get(G[i.prod][n].n())) << " ";
@@ -240,40 +297,98 @@ typename earley<CharT>::ostream& earley<CharT>::print(
 	return os;
 }
 
+// adds the item to its set unless it is there already, with the items it
+// advances to over nullable symbols
 template <typename CharT>
-typename earley<CharT>::container_iter earley<CharT>::add(container_t& t, 
-		const item& i) {
+bool earley<CharT>::add(const item& i) {
 	//DBG(print(o::dbg() << "adding ", i) << endl;)
-	auto& cont = S[i.set];
-	auto it = cont.find(i);
-	if (it != cont.end()) return it;
-	if ((it = t.find(i)) != t.end()) return it;
-	it = t.insert(i).first;
-	if (nullable(*it))
-		add(t, item(it->set, it->prod, it->from, it->dot + 1));
-			//->advancers.insert(i);
-	return it;
+	eset& cont = S[i.set];
+	auto r = cont.items.insert(i);
+	if (!r.second) return false;
+	const item& it = *r.first;
+	cont.order.push_back(&it);
+	bool advance = nullable(it);
+	if (!completed(it) && get_lit(it).nt()) {
+		const size_t nt = get_lit(it).n();
+		cont.postdot[nt].push_back(&it);
+		advance = advance || cont.nulled.count(nt);
+	}
+	if (advance) add(item(it.set, it.prod, it.from, it.dot + 1));
+		//->advancers.insert(i);
+	return true;
 }
 
+// the topmost item of the deterministic reduction path above nt in the set:
+// the only item of the set waiting on nt if nt is the last symbol of its
+// rule, or the topmost item above the nonterminal of that rule in turn
 template <typename CharT>
-void earley<CharT>::complete(const item& i, container_t& t) {
-	//DBG(print(o::dbg() << "completing ", i) << endl;)
-	const container_t& cont = S[i.from];
-	for (auto it = cont.begin(); it != cont.end(); ++it)
-		if (G[it->prod].size() > it->dot &&
-			get_lit(*it) == get_nt(i))
-			add(t, item(i.set, it->prod, it->from, it->dot + 1));
-				//completers.insert(i);
+const typename earley<CharT>::item* earley<CharT>::leo_item(size_t set,
+	size_t nt)
+{
+	eset& s = S[set];
+	if (auto it = s.leo.find(nt); it != s.leo.end()) return it->second;
+	const item* r = 0;
+	auto it = s.postdot.find(nt);
+	if (it != s.postdot.end() && it->second.size() == 1 &&
+		it->second[0]->dot + 1 == G[it->second[0]->prod].size())
+	{
+		r = it->second[0];
+		// predicted within the set, which could go up a cycle
+		if (r->from != set)
+			if (const item* t = leo_item(r->from, get_nt(*r).n()))
+				r = t;
+	}
+	return s.leo[nt] = r;
+}
+
+// adds the completed items which Leo's optimization skipped in the set, as
+// the forest is built from completed items, and preprocesses them if pre
+template <typename CharT>
+void earley<CharT>::leo_expand(size_t set, bool pre) {
+	if (S[set].expanded) return;
+	S[set].expanded = true;
+	for (size_t k = 0; k != S[set].leo_done.size(); ++k)
+		for (auto [nt, from] = S[set].leo_done[k];;) {
+			const item& w = *S[from].postdot[nt][0];
+			item c(set, w.prod, w.from, w.dot + 1);
+			// the rest of the path is there as well
+			if (!add(c)) break;
+			if (pre) pre_process(c);
+			nt = get_nt(w).n(), from = w.from;
+		}
 }
 
 template <typename CharT>
-void earley<CharT>::predict(const item& i, container_t& t) {
-	//DBG(print(o::dbg() << "predicting ", i) << endl;)
-	for (size_t p : nts[get_lit(i)]) {
-		item j(i.set, p, i.set, 1);
-		add(t, j); //->advancers.insert(i);
-		//DBG(print(o::dbg() << "predicting added ", j) << endl;)
+void earley<CharT>::complete(const item& i) {
+	//DBG(print(o::dbg() << "completing ", i) << endl;)
+	const size_t nt = get_nt(i).n();
+	if (i.from == i.set) S[i.set].nulled.insert(nt);
+	else if (leo) if (const item* t = leo_item(i.from, nt)) {
+		S[i.set].leo_done.emplace_back(nt, i.from);
+		add(item(i.set, t->prod, t->from, t->dot + 1));
+		return;
 	}
+	auto& waiting = S[i.from].postdot;
+	auto it = waiting.find(nt);
+	if (it == waiting.end()) return;
+	// grows meanwhile if the item is completed within its set
+	const vector<const item*>& w = it->second;
+	for (size_t k = 0; k != w.size(); ++k)
+		add(item(i.set, w[k]->prod, w[k]->from, w[k]->dot + 1));
+			//completers.insert(i);
+}
+
+template <typename CharT>
+void earley<CharT>::predict(size_t set, size_t nt) {
+	//DBG(o::dbg() << "predicting " << d.get(nt) << endl;)
+	if (nt >= closure.size() || predicted[nt] == set + 1) return;
+	for (size_t x : closure[nt])
+		if (predicted[x] != set + 1) {
+			predicted[x] = set + 1;
+			for (size_t p : nt_prods[x])
+				add(item(set, p, set, 1));
+				//->advancers.insert(i);
+		}
 }
 
 template <typename CharT>
@@ -288,19 +403,17 @@ void earley<CharT>::scan_builtin(const item& i, size_t n, const string& s) {
 		p = G.size(); // its a new character in this builtin -> store it 
 		G.push_back({ get_lit(i) });
 		G.back().push_back(lit{ ch });
+		compile(p);
 		builtin_char_prod[bid][ch] = p; // store prod of this ch
 	} else p = it->second; // this ch has its prod already
-	item j(n + !eof, i.prod, n, 2); // complete builtin
-	S[j.set].insert(j);
-	item k(n + !eof, p, n, 2);      // complete builtin's character
-	S[k.set].insert(k);
+	add(item(n + !eof, i.prod, n, 2)); // complete builtin
+	add(item(n + !eof, p, n, 2));      // complete builtin's character
 }
 
 template <typename CharT>
 void earley<CharT>::scan(const item& i, size_t n, CharT ch) {
 	if (ch != get_lit(i).c()) return;
-	item j(n + 1, i.prod, i.from, i.dot + 1);
-	S[j.set].insert(j);
+	add(item(n + 1, i.prod, i.from, i.dot + 1));
 	//first->advancers.insert(i);
 	//DBG(print(o::dbg(), i) << ' ';)
 	//DBG(print(o::dbg() << "scanned " << ch << " and added ", j) << "\n";)
@@ -321,17 +434,12 @@ bool earley<CharT>::recognize(const typename earley<CharT>::string s) {
 	size_t len = s.size();
 	pfgraph.clear();
 	bin_tnt.clear();
+	sorted_citem.clear(), rsorted_citem.clear();
 	tid = 0;
 	S.clear();//, S.resize(len + 1);//, C.clear(), C.resize(len + 1);
 	S.resize(len+1);
-	for (size_t n : nts[start]) {
-		auto& cont = S[0];
-		auto it = cont.emplace(0, n, 0, 1).first;
-		// fix the bug for missing Start( 0 0) when start is nulllable
-		if(nullable(*it))
-			cont.emplace(0, n, 0, 2);
-	}
-	container_t t;
+	predicted.assign(predicted.size(), 0);
+	predict(0, start.n());
 #ifdef DEBUG
 	size_t r = 1, cb = 0; // row and cel beginning
 #endif
@@ -340,20 +448,16 @@ bool earley<CharT>::recognize(const typename earley<CharT>::string s) {
 		if (s[n] == '\n') (cb = n), r++;
 		emeasure_time_start(tsp, tep);
 #endif
-		do {
-			for(const item &x : t) S[x.set].insert(x);
-			t.clear();
-			const auto& cont = S[n];
-			for (auto it = cont.begin();
-				it != cont.end(); ++it) {
-				//DBG(print(o::dbg() << "processing ", *it) << endl;)
-				if (completed(*it)) complete(*it, t);
-				else if (get_lit(*it).is_builtin()) {
-					if (n <= len) scan_builtin(*it, n, s);
-				} else if (get_lit(*it).nt()) predict(*it, t);
-				else if (n < len) scan(*it, n, s[n]);
-			}
-		} while (!t.empty());
+		// items added to the set meanwhile are processed in turn
+		for (size_t k = 0; k != S[n].size(); ++k) {
+			const item& it = S[n][k];
+			//DBG(print(o::dbg() << "processing ", it) << endl;)
+			if (completed(it)) complete(it);
+			else if (get_lit(it).is_builtin()) {
+				if (n <= len) scan_builtin(it, n, s);
+			} else if (get_lit(it).nt()) predict(n, get_lit(it).n());
+			else if (n < len) scan(it, n, s[n]);
+		}
 #ifdef DEBUG
 		if (pms) {
 			o::pms()<<n<<" \tln: "<<r<<" col: "<<(n-cb+1)<<" :: ";
@@ -375,6 +479,7 @@ bool earley<CharT>::recognize(const typename earley<CharT>::string s) {
 */
 		if (true == incr_gen_forest) {
 		DBG(o::dbg() << "set: " << n << endl;)
+		leo_expand(n, false);
 		const auto& cont = S[n];
 		for (auto it = cont.begin(); it != cont.end(); ++it)
 			if(completed(*it)) pre_process(*it);
@@ -390,8 +495,9 @@ bool earley<CharT>::recognize(const typename earley<CharT>::string s) {
 		}
 	}
 	bool found = false;
+	leo_expand(len, false);
 	for (size_t n : nts[start])
-		if (S[len].find( item(len, n, 0, G[n].size())) != S[len].end()) 
+		if (S[len].items.count(item(len, n, 0, G[n].size())))
 			found = true;
 	emeasure_time_end(tsr, ter) <<" :: recognize time" <<endl;
 	if(!incr_gen_forest) forest();
@@ -454,33 +560,35 @@ bool earley<CharT>::iterate_forest(T out_rel, P &&pt) const {
 		return args;
 	};
 
-	map<nidx_t, size_t> nid;
+	const parse_forest_t& f = pt.size() ? pt : pfgraph;
+	const vector<size_t> sorted = f.sorted();
+	vector<size_t> nid(f.nodes.size(), f.npos);
 	size_t id = 0;
-	for (auto &it: pt.size() ? pt : pfgraph) {
-		nid[it.first] = id;
+	for (size_t n : sorted) {
+		nid[n] = id;
 		// skip ids for one child ambig node
-		id += it.second.size()== 1 ? 0 : it.second.size(); // ambig node ids;
-		//DBG(assert(it.second.size()!= 0));
+		size_t packs = f.np[n].second;
+		id += packs == 1 ? 0 : packs; // ambig node ids;
 		id++;
 	}
 	ss << std::endl;
 	string node_s{ 'n', 'o', 'd', 'e' }, edge_s{ 'e', 'd', 'g', 'e' };
-	for (auto &it : pt.size()? pt : pfgraph) {
-		arg_t ndesc = get_args(it.first);
-		out_rel(node_s, nid[it.first], ndesc);
-		size_t p = 0;
-		for (auto &pack : it.second) {
-			if (it.second.size() > 1) {  //skipping if only one ambigous node, an optimization
-				++p;
-				out_rel(edge_s, nid[it.first],
-						{ nid[it.first] + p } );
-				out_rel(node_s, nid[it.first] + p, {} );
+	for (size_t n : sorted) {
+		arg_t ndesc = get_args(f[n]);
+		out_rel(node_s, nid[n], ndesc);
+		auto [pb, pe] = f.node_packs(n);
+		for (size_t p = pb; p != pe; ++p) {
+			size_t pid = nid[n];
+			if (pe - pb > 1) {  //skipping if only one ambigous node, an optimization
+				pid += p - pb + 1;
+				out_rel(edge_s, nid[n], { pid } );
+				out_rel(node_s, pid, {} );
 			}
-			for (auto & nn: pack) {
-				if (nid.find(nn) == nid.end()) nid[nn] = id++; // for terminals, not seen before
-				arg_t nndesc = get_args(nn);
-				out_rel(node_s, nid[nn], nndesc);
-				out_rel(edge_s, nid[it.first] + p, { nid[nn] });
+			for (auto [k, ke] = f.pack(p); k != ke; ++k) {
+				if (nid[*k] == f.npos) nid[*k] = id++; // for terminals, not seen before
+				arg_t nndesc = get_args(f[*k]);
+				out_rel(node_s, nid[*k], nndesc);
+				out_rel(edge_s, pid, { nid[*k] });
 			}
 		}
 	}
@@ -493,8 +601,10 @@ template <typename cb_enter_t, typename cb_exit_t, typename cb_revisit_t,
 bool earley<CharT>::traverse_forest(const nidx_t &root, cb_enter_t cb_enter,
 	cb_exit_t cb_exit, cb_revisit_t cb_revisit, cb_ambig_t cb_ambig)
 {
-	std::set<nidx_t> done;
-	return _traverse_forest(root, done,
+	size_t id = pfgraph.find(root);
+	if (id == pfgraph.npos) return false;
+	std::vector<bool> done(pfgraph.nodes.size());
+	return _traverse_forest(id, done,
 		cb_enter, cb_exit, cb_revisit, cb_ambig);
 }
 
@@ -502,26 +612,26 @@ bool earley<CharT>::traverse_forest(const nidx_t &root, cb_enter_t cb_enter,
 template <typename CharT>
 template <typename cb_enter_t, typename cb_exit_t, typename cb_revisit_t,
 	typename cb_ambig_t>
-bool earley<CharT>::_traverse_forest(const nidx_t &root, std::set<nidx_t> &done,
+bool earley<CharT>::_traverse_forest(size_t root, std::vector<bool> &done,
 	cb_enter_t cb_enter, cb_exit_t cb_exit, cb_revisit_t cb_revisit,
 	cb_ambig_t cb_ambig)
 {
 	bool ret = true;
-	std::set<std::vector<nidx_t>> pack;
-	if (root.nt()) {
-		auto it = pfgraph.find(root);
-		if (it == pfgraph.end()) return false;
-		pack = it->second;
+	std::vector<size_t> pack;
+	if (pfgraph[root].nt()) {
+		if (!pfgraph.is_built(root)) return false;
+		auto [pb, pe] = pfgraph.node_packs(root);
+		for (size_t p = pb; p != pe; ++p) pack.push_back(p);
 	}
 	cb_enter(root);
-	done.insert(root);
+	done[root] = true;
 
-	std::set<std::vector<nidx_t>> choosen_pack = pack.size() > 1
+	std::vector<size_t> choosen_pack = pack.size() > 1
 		? cb_ambig(root, pack) : pack; 
-	for (auto &nodes: choosen_pack)
-		for (auto &chd: nodes)
-			if (!done.count(chd) || cb_revisit(chd)) 
-				ret &= _traverse_forest(chd, done, cb_enter,
+	for (size_t p : choosen_pack)
+		for (auto [chd, e] = pfgraph.pack(p); chd != e; ++chd)
+			if (!done[*chd] || cb_revisit(*chd)) 
+				ret &= _traverse_forest(*chd, done, cb_enter,
 					cb_exit, cb_revisit, cb_ambig);
 	cb_exit(root, choosen_pack);
 	return ret;
@@ -533,27 +643,36 @@ typename earley<CharT>::ptree_t earley<CharT>::get_parsed_tree() {
 	nidx_t root(start, { 0, inputstr.length() });
 	ptree_t pt;
 
-	auto cb_enter = [](const nidx_t&){};
-	auto cb_revisit = [](const auto&){ return false; };
-	auto cb_exit = [&pt](const nidx_t& root,
-		const std::set<std::vector<nidx_t>>& choice_set)
+	auto cb_enter = [](size_t){};
+	auto cb_revisit = [](size_t){ return false; };
+	auto cb_exit = [&pt, this](size_t root,
+		const std::vector<size_t>& choice_set)
 	{
 		DBG( assert(choice_set.size() <= 1));
-		if (root.nt()) pt.insert({root, choice_set});
+		if (!pfgraph[root].nt()) return;
+		std::set<std::vector<nidx_t>> packs;
+		for (size_t p : choice_set) {
+			std::vector<nidx_t> pack;
+			for (auto [k, e] = pfgraph.pack(p); k != e; ++k)
+				pack.push_back(pfgraph[*k]);
+			packs.insert(pack);
+		}
+		size_t id = pt.get(pfgraph[root]);
+		if (!pt.is_built(id)) pt.set(id, packs);
 	};
-	auto cb_disambig_by_priority = [this](const nidx_t& root,
-		const std::set<std::vector<nidx_t>>& ambset)
+	auto cb_disambig_by_priority = [this](size_t root,
+		const std::vector<size_t>& ambset)
 	{
-		DBG(assert(root.nt()));
+		DBG(assert(pfgraph[root].nt()));
 		int_t cur = -1, pchoice = INT32_MIN, maxp = INT32_MIN,
 			pref_choice = INT32_MIN;
 
-		for (auto & choice : ambset) {
+		for (size_t choice : ambset) {
 			std::vector<lit> gprod;
-			gprod.push_back(root.l);
+			gprod.push_back(pfgraph[root].l);
 			//get the production
-			for( auto & nd : choice)
-				gprod.emplace_back(nd.l);
+			for (auto [k, e] = pfgraph.pack(choice); k != e; ++k)
+				gprod.emplace_back(pfgraph[*k].l);
 			
 			++cur;
 			// find the top priority if any
@@ -568,11 +687,8 @@ typename earley<CharT>::ptree_t earley<CharT>::get_parsed_tree() {
 				" defaulting to first choice!\n";
 			pchoice = 0;
 		}
-		std::set<std::vector<nidx_t>> choosen;
-		auto it = std::next(ambset.begin(),
-			int_t(pchoice >= 0 ? pchoice : pref_choice));
-		choosen.insert(*it );
-		return choosen;
+		return std::vector<size_t>{ ambset[
+			pchoice >= 0 ? pchoice : pref_choice] };
 	};
 
 	traverse_forest(root, cb_enter, cb_exit, cb_revisit,
@@ -586,19 +702,26 @@ uintmax_t earley<CharT>::count_parsed_trees() {
 	
 	size_t count = 1;
 	
-	auto cb_enter = [](const auto&) {};
-	auto cb_exit =  [](const auto&, const auto&) {};
-	auto cb_keep_ambig = [&count](const nidx_t&, auto& ambset) {
+	auto cb_enter = [](size_t) {};
+	auto cb_exit =  [](size_t, const auto&) {};
+	auto cb_keep_ambig = [&count](size_t, auto& ambset) {
 		count *= ambset.size();
 		return ambset;
 	};
-	auto cb_revisit =  [](const auto&) { return false; }; // revisit
+	auto cb_revisit =  [](size_t) { return false; }; // revisit
 
 	traverse_forest(root, cb_enter, cb_exit, cb_revisit, cb_keep_ambig);
 
 	return count; 
 }
 
+template <typename CharT>
+size_t earley<CharT>::count_items() const {
+	size_t n = 0;
+	for (const eset& s : S) n += s.size();
+	return n;
+}
+
 template <typename CharT>
 vector<typename earley<CharT>::arg_t> earley<CharT>::get_parse_graph_facts() {
 	vector<arg_t> rts;
@@ -626,15 +749,17 @@ template <typename CharT>
 template <typename P>
 bool earley<CharT>::to_tml_rule(ostream_t& ss, P &&pt) const{
 	set<std::string> terminals;
-	for (auto &it: pt.size()? pt : pfgraph ) {
-		for (auto &pack : it.second) { 
-			ss << to_tml_rule(it.first) << ":-";
-			for (size_t i = 0; i < pack.size(); i++) {
+	const parse_forest_t& f = pt.size() ? pt : pfgraph;
+	for (size_t n : f.sorted()) {
+		auto [pb, pe] = f.node_packs(n);
+		for (size_t p = pb; p != pe; ++p) { 
+			ss << to_tml_rule(f[n]) << ":-";
+			for (auto [k, e] = f.pack(p); k != e; ++k) {
 				// if terminal
-				if (pfgraph.find(pack[i]) == pfgraph.end())
-					terminals.insert(to_tml_rule(pack[i]));
-				ss << to_tml_rule(pack[i])
-					<< (i == pack.size()-1 ? "." : ",");
+				if (!pfgraph.count(f[*k]))
+					terminals.insert(to_tml_rule(f[*k]));
+				ss << to_tml_rule(f[*k])
+					<< (k + 1 == e ? "." : ",");
 			};
 			ss << "\n";
 		}
@@ -703,20 +828,21 @@ bool earley<CharT>::to_dot(ostream_t& ss, P &&pt) const {
 
 	std::unordered_set<std::pair<size_t,size_t>, hasher_t> edgedone;
 	edgedone.clear();
-	for (auto &it: pt.size() ? pt : pfgraph) {
-		auto key = keyfun(it.first);
+	const parse_forest_t& f = pt.size() ? pt : pfgraph;
+	for (size_t n : f.sorted()) {
+		auto key = keyfun(f[n]);
 		ss << "\n" << key.first << "[label=\"" << key.second <<"\"];";
-		size_t p = 0;
+		auto [pb, pe] = f.node_packs(n);
 		std::stringstream pstr;
-		for (auto &pack : it.second) {
-			pstr<<key.second<<p++;
+		for (size_t p = pb; p != pe; ++p) {
+			pstr<<key.second<<p - pb;
 			auto ambkey = std::hash<std::string>()(pstr.str());
 			ss << "\n" << ambkey << "[shape = point,label=\"" <<
 				pstr.str() << "\"];";
 			if (edgedone.insert({ key.first, ambkey }).second)
 				ss << "\n" << key.first << "->" << ambkey <<';';
-			for (auto & nn: pack) {
-				auto nkey = keyfun(nn);
+			for (auto [k, e] = f.pack(p); k != e; ++k) {
+				auto nkey = keyfun(f[*k]);
 				ss << "\n" << nkey.first << "[label=\"" <<
 					nkey.second << "\"];";
 				if (edgedone.insert({ ambkey, nkey.first })
@@ -940,45 +1066,52 @@ bool earley<CharT>::bin_lr_comb(const item& eitem,
 template <typename CharT>
 bool earley<CharT>::build_forest ( const nidx_t &root ) {
 	if (!root.nt()) return false;
-	if (pfgraph.find(root) != pfgraph.end()) return false;
+	if (pfgraph.count(root)) return false;
 
+	leo_expand(root.span.second, true);
 	//auto &nxtset = sorted_citem[root.n()][root.span.first];
 	auto &nxtset = sorted_citem[{root.n(),root.span.first}];
 	std::set<std::vector<nidx_t>> ambset;
-	for (const item &cur : nxtset) {
+	size_t id = pfgraph.npos;
+	// grows if building children adds items skipped by Leo's optimization
+	for (size_t k = 0; k != nxtset.size(); ++k) {
+		const item cur = nxtset[k];
 		if (cur.set != root.span.second) continue;
 		assert(root.n() == G[cur.prod][0].n() );
-		nidx_t cnode( G[cur.prod][0], {cur.from, cur.set} );
+		// built before its children, which may lead back to it
+		if (id == pfgraph.npos) pfgraph.build(id = pfgraph.get(root));
 		vector<nidx_t> nxtlits;
 		sbl_chd_forest(cur, nxtlits, cur.from, ambset );
-		pfgraph[cnode] = ambset;
 		for (auto &aset : ambset)
 			for (const nidx_t& nxt : aset) {
 				build_forest(nxt);
 			}
 	}	
+	if (id != pfgraph.npos) pfgraph.set(id, ambset);
 	return true;
 }
 
 template <typename CharT>
 bool earley<CharT>::build_forest2 (const nidx_t &root) {
 	if (!root.nt()) return false;
-	if (pfgraph.find(root) != pfgraph.end()) return false;
+	if (pfgraph.count(root)) return false;
 
+	leo_expand(root.span.second, true);
 	//auto &nxtset = sorted_citem[root.n()][root.span.first];
 	auto &nxtset = sorted_citem[{ root.n(),root.span.first }];
 	std::set<std::vector<nidx_t>> ambset;
-	for (const item &cur: nxtset) {
+	size_t id = pfgraph.npos;
+	for (size_t k = 0; k != nxtset.size(); ++k) {
+		const item cur = nxtset[k];
 		if (cur.set != root.span.second) continue;
-		nidx_t cnode(completed(cur) ? G[cur.prod][0] : lit{ root.n() },
-			{ cur.from, cur.set } );
+		if (id == pfgraph.npos) pfgraph.build(id = pfgraph.get(root));
 		bin_lr_comb(cur, ambset);
-		pfgraph[cnode] = ambset;
 		for (auto &aset: ambset )
 			for (const nidx_t& nxt : aset) {
 				build_forest2(nxt);
 			}
 	}
+	if (id != pfgraph.npos) pfgraph.set(id, ambset);
 	return true;
 }
 
@@ -990,16 +1123,18 @@ vector<typename earley<CharT>::node_children> earley<CharT>::get_children(
 	auto label = [this](const nidx_t p, bool all=1) {
 		return p.nt() ? d.get(p.n()) : (all ? string{p.c()} : string{});
 	};
-	auto it = pfgraph.find(nd);
-	if (it == pfgraph.end()) return {{}};
+	size_t id = pfgraph.find(nd);
+	if (id == pfgraph.npos || !pfgraph.is_built(id)) return {{}};
+	auto [pb, pe] = pfgraph.node_packs(id);
 	bool amb = false;
-	if (print_ambiguity && it->second.size() > 1) amb = true, o::inf() <<"'"
+	if (print_ambiguity && pe - pb > 1) amb = true, o::inf() <<"'"
 		<< to_stdstr(label(nd, true)) <<"' is ambiguous\n";
 	size_t c = 0;
-	for (auto &pack : it->second) {
+	for (size_t k = pb; k != pe; ++k) {
 		if (amb) o::inf() << "\tpack " << ++c << ":\t";
 		ncs.emplace_back();
-		for (auto& p : pack) {
+		for (auto [kid, e] = pfgraph.pack(k); kid != e; ++kid) {
+			const nidx_t& p = pfgraph[*kid];
 			if (amb) o::inf() << "\t'" <<
 				to_stdstr(label(p, true)) << "' ";
 			ncs.back().push_back(
@@ -1021,11 +1156,12 @@ typename earley<CharT>::string earley<CharT>::shorten(const string& s,
 template <typename CharT>
 typename earley<CharT>::string earley<CharT>::flatten(const nidx_t p) const {
 	stringstream ss;
-	auto it = pfgraph.find(p);
-	if (it == pfgraph.end()) return {{}};
-	for (auto &pack : it->second) {
-		for (auto &p : pack)
-			if (p.nt()) {
+	size_t id = pfgraph.find(p);
+	if (id == pfgraph.npos || !pfgraph.is_built(id)) return {{}};
+	auto [pb, pe] = pfgraph.node_packs(id);
+	for (size_t k = pb; k != pe; ++k) {
+		for (auto [kid, e] = pfgraph.pack(k); kid != e; ++kid)
+			if (const nidx_t& p = pfgraph[*kid]; p.nt()) {
 				auto flat = flatten(p);
 				if (flat.size() && flat[0] != 0 &&
 					flat[0] != char_traits<CharT>::eof())
@@ -1070,10 +1206,9 @@ void earley<CharT>::down(const nidx_t& p, const actions& a) const {
 
 template <typename CharT>
 void earley<CharT>::topdown(const string& start, const actions& a) const {
-	auto it = pfgraph.begin();
-	for ( ; it != pfgraph.end() &&
-		!(it->first.nt() && d.get(it->first.n()) == start); ++it) ;
-	if (it != pfgraph.end()) down(it->first, a);
+	for (size_t n : pfgraph.sorted())
+		if (pfgraph[n].nt() && d.get(pfgraph[n].n()) == start)
+			return down(pfgraph[n], a);
 }
 
 template <>
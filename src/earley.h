@@ -59,6 +59,8 @@ public:
 	bool print_ambiguity  = false;
 	bool print_traversing = false;
 	bool auto_passthrough = true;
+	// Leo's optimization: completing right recursion in linear time
+	bool leo = true;
 private:
 	struct lit : public lit_t {
 		using typename lit_t::variant;
@@ -111,7 +113,7 @@ private:
 	struct item {
 		item(size_t set, size_t prod, size_t from, size_t dot) :
 			set(set), prod(prod), from(from), dot(dot) {}
-		size_t set, prod, from, dot;
+		uint32_t set, prod, from, dot;
 		// mutable std::set<item> advancers, completers;
 		bool operator<(const item& i) const {
 			if (set != i.set) return set < i.set;
@@ -134,13 +136,20 @@ private:
 	ostream& print(ostream& os, const item& i) const;
 	void scan(const item& i, size_t n, CharT ch);
 	void scan_builtin(const item& i, size_t n, const string& s);
-	bool nullable(const item& i) const {
-		return i.dot < G[i.prod].size() &&
-			((get_lit(i).nt() &&
-			nullables.find(get_lit(i).n()) !=
-			nullables.end()) ||
-			(!get_lit(i).nt() && get_lit(i).c() == '\0'));
-	}
+	bool nullable(const item& i) const { return nulls[dr[i.prod] + i.dot]; }
+
+	// The grammar compiled for the recognizer. The dotted rules of each
+	// production are numbered from dr[prod], with whether the symbol after
+	// the dot is nullable. Predicting a nonterminal predicts all those in
+	// its closure, each adding the items of its productions, once per set.
+	std::vector<size_t> dr;
+	std::vector<bool> nulls;
+	std::vector<std::vector<size_t>> nt_prods;
+	std::vector<std::vector<size_t>> closure;
+	// the set + 1 in which each nonterminal was last predicted
+	std::vector<size_t> predicted;
+	void compile();
+	void compile(size_t prod);
 
 	struct {
 		std::map<string, size_t> m;
@@ -153,12 +162,92 @@ private:
 		}
 		string get(size_t n) const { return v[n]; }
 	} d;
-	
+	struct hasher_t{
+		size_t hash_size_t(const size_t &val) const{
+			return std::hash<size_t>()(val) + 0x9e3779b9 +
+							(val << 6) + (val >> 2);
+		}
+		size_t operator()(const std::pair<size_t, size_t> &k) const {
+			// lets substitute with better if possible.
+			std::size_t h = 0;
+			h ^= hash_size_t(k.first); 
+			h ^= hash_size_t(k.second);
+			return h;
+		}
+		size_t operator()(const pnode &k) const {
+			// combined in turn, as xoring the spans of the forest's
+			// nodes collides too often
+			std::size_t h = hash_size_t(k.span.first);
+			h ^= hash_size_t(k.span.second) + (h << 6) + (h >> 2);
+			h ^= hash_size_t(size_t(k.l.nt()?k.l.n():k.c())) +
+				(h << 6) + (h >> 2);
+			return h;
+		}
+		size_t operator()(const item &k) const {
+			// lets substitute with better if possible.
+			std::size_t h = 0;
+			h ^= hash_size_t(k.set);
+			h ^= hash_size_t(k.from);
+			h ^= hash_size_t(k.prod);
+			h ^= hash_size_t(k.dot);
+			return h;
+		}
+	};
+
 public:
 	typedef std::map<item, std::set<std::vector<item>>> item_forest_t;
 	
 	typedef pnode nidx_t;
-	typedef std::map<nidx_t, std::set<std::vector<nidx_t>>> parse_forest_t;
+	// The shared packed parse forest. Nodes are interned by their lit and
+	// span into ids and the packs of the built ones are kept in arenas: a
+	// node has a range of packs and a pack a range of child ids.
+	struct parse_forest_t {
+		static constexpr size_t npos = SIZE_MAX;
+		std::vector<nidx_t> nodes;
+		// first pack and number of packs, npos if the node is not built
+		std::vector<std::pair<size_t, size_t>> np;
+		// first child and number of children
+		std::vector<std::pair<size_t, size_t>> packs;
+		std::vector<size_t> kids;
+		std::vector<size_t> built;
+		std::unordered_map<nidx_t, size_t, hasher_t> ids;
+		size_t size() const { return built.size(); }
+		const nidx_t& operator[](size_t id) const { return nodes[id]; }
+		size_t get(const nidx_t& n) {
+			auto r = ids.emplace(n, nodes.size());
+			if (r.second) nodes.push_back(n), np.emplace_back(npos, 0);
+			return r.first->second;
+		}
+		size_t find(const nidx_t& n) const {
+			auto it = ids.find(n);
+			return it == ids.end() ? npos : it->second;
+		}
+		bool is_built(size_t id) const { return np[id].first != npos; }
+		bool count(const nidx_t& n) const {
+			size_t id = find(n);
+			return id != npos && is_built(id);
+		}
+		// marks the node built before its packs are known
+		void build(size_t id) {
+			if (!is_built(id)) np[id] = { packs.size(), 0 },
+				built.push_back(id);
+		}
+		void set(size_t id, const std::set<std::vector<nidx_t>>& ambset);
+		// the packs of a node and the children of a pack as ranges
+		std::pair<size_t, size_t> node_packs(size_t id) const {
+			return { np[id].first, np[id].first + np[id].second };
+		}
+		std::pair<const size_t*, const size_t*> pack(size_t p) const {
+			const size_t* k = kids.data() + packs[p].first;
+			return { k, k + packs[p].second };
+		}
+		// the built nodes in the order of their lit and span
+		std::vector<size_t> sorted() const;
+		void clear() {
+			nodes.clear(), np.clear(), packs.clear(), kids.clear(),
+			built.clear(), ids.clear();
+		}
+	};
 	typedef parse_forest_t ptree_t;
 	typedef std::vector<std::variant<size_t, string>> arg_t;
 	typedef std::vector<std::pair<string, const nidx_t>> node_children;
@@ -184,6 +273,7 @@ public:
 	uintmax_t count_parsed_trees() ;
 	ptree_t get_parsed_tree();
 
+	// the callbacks get the ids of nodes and packs in the forest
 	template <typename cb_enter_t, typename cb_exit_t,
 		typename cb_revisit_t, typename cb_ambig_t>
 	bool traverse_forest(const nidx_t &root, cb_enter_t cb_enter, 
@@ -201,10 +291,11 @@ public:
 	string flatten(const nidx_t nd) const;
 	ptree_t get_parsed_tree(size_t);
 	size_t count_parsed_trees() const;
+	size_t count_items() const;
 private:
 	template <typename cb_enter_t, typename cb_exit_t,
 		typename cb_revisit_t, typename cb_ambig_t>
-	bool _traverse_forest(const nidx_t &root, std::set<nidx_t> &done,
+	bool _traverse_forest(size_t root, std::vector<bool> &done,
 		cb_enter_t cb_enter, cb_exit_t cb_exit, cb_revisit_t cb_revisit,
 		cb_ambig_t cb_ambig);
 	string epsilon() const;
@@ -227,36 +318,6 @@ private:
 	std::string dot_safe(const std::string& s) const;
 	std::string to_stdstr(const string& s) const;
 	std::string to_stdstr(const char32_t& s) const;
-	struct hasher_t{
-		size_t hash_size_t(const size_t &val) const{
-			return std::hash<size_t>()(val) + 0x9e3779b9 +
-							(val << 6) + (val >> 2);
-		}
-		size_t operator()(const std::pair<size_t, size_t> &k) const {
-			// lets substitute with better if possible.
-			std::size_t h = 0;
-			h ^= hash_size_t(k.first); 
-			h ^= hash_size_t(k.second);
-			return h;
-		}
-		size_t operator()(const nidx_t &k) const {
-			// lets substitute with better if possible.
-			std::size_t h = 0;
-			h ^= hash_size_t(k.span.first); 
-			h ^= hash_size_t(k.span.second);
-			h ^= hash_size_t(size_t(k.l.nt()?k.l.n():k.c()));
-			return h;
-		}
-		size_t operator()(const item &k) const {
-			// lets substitute with better if possible.
-			std::size_t h = 0;
-			h ^= hash_size_t(k.set);
-			h ^= hash_size_t(k.from);
-			h ^= hash_size_t(k.prod);
-			h ^= hash_size_t(k.dot);
-			return h;
-		}
-	};
 	//std::unordered_map< size_t, 
 	//	std::unordered_map<size_t, std::vector<item>>>  sorted_citem;
 	std::unordered_map<std::pair<size_t, size_t>, std::vector<item>,
@@ -289,11 +350,44 @@ private:
 	template <typename CharU>
 	friend int test_out(int c, earley<CharU> &e);
 	typedef std::unordered_set<earley<CharT>::item, earley<CharT>::hasher_t> container_t;
-	typedef typename container_t::iterator container_iter;
-	std::vector<container_t> S;
-	container_iter add(container_t& t, const item& i);
-	void complete(const item& i, container_t& t);
-	void predict(const item& i, container_t& t);
+	// An Earley set, whose items are processed once each in the order they
+	// were added in, so that items added while processing it are appended
+	struct eset {
+		container_t items;
+		std::vector<const item*> order;
+		// items by the nonterminal after their dot, for completion
+		std::unordered_map<size_t, std::vector<const item*>> postdot;
+		// nonterminals completed within the set, which advance items
+		// waiting on them even if these are added later
+		std::unordered_set<size_t> nulled;
+		// the topmost items of the deterministic reduction paths above
+		// nonterminals, or 0 if there is none (Leo)
+		std::unordered_map<size_t, const item*> leo;
+		// nonterminals and origins whose completions in this set went
+		// up a reduction path, skipping the completed items on the way
+		std::vector<std::pair<size_t, size_t>> leo_done;
+		// whether the skipped items were added, for the forest
+		bool expanded = false;
+		size_t size() const { return order.size(); }
+		const item& operator[](size_t k) const { return *order[k]; }
+		// iterates in the order the items were added in, not hashed in
+		struct iterator {
+			typename std::vector<const item*>::const_iterator it;
+			const item& operator*() const { return **it; }
+			const item* operator->() const { return *it; }
+			iterator& operator++() { return ++it, *this; }
+			bool operator!=(const iterator& x) const {
+				return it != x.it; }
+		};
+		iterator begin() const { return { order.begin() }; }
+		iterator end() const { return { order.end() }; }
+	};
+	std::vector<eset> S;
+	bool add(const item& i);
+	const item* leo_item(size_t set, size_t nt);
+	void leo_expand(size_t set, bool pre);
+	void complete(const item& i);
+	void predict(size_t set, size_t nt);
 
 
 	struct overlay_tree {
@@ -87,5 +87,15 @@ const char err_internal_term[] = "Expected term whose relation is to be marked a
 const char err_x_escape[] = "Wrong \\x character escape. Use values between: \\x00 and \\xFF.";
 const char err_u_escape[] = "Wrong \\u character escape. Use values between: \\u0000 and \\uFFFF.";
 const char err_neg_fact[] = "Facts cannot be negated.";
+const char err_facts_only[] = "Only facts without variables can be added or retracted.";
+const char err_db_fixpoint[] = "No fixpoint to save into the database.";
+const char err_db_write[] = "Unable to write the database file.";
+const char err_db_read[] = "Unable to read the database file.";
+const char err_db_format[] = "Malformed database file or one of another version.";
+const char err_db_dict[] = "Database symbols clash with symbols already in use.";
+const char err_load_spec[] = "Facts to load have to be given as REL=FILE.";
+const char err_load_read[] = "Unable to read the file of facts to load.";
+const char err_load_format[] = "Malformed record or one of another arity at ";
+const char err_profile_write[] = "Unable to write the profile file.";
 
 #endif
@@ -15,6 +15,10 @@
 #include <sstream>
 #include <fstream>
 #include <vector>
+#ifdef WITH_THREADS
+#include <thread>
+#include <atomic>
+#endif
 #include "input.h"
 #include "err.h"
 #include "output.h"
@@ -26,6 +30,7 @@ int_t raw_prog::last_id = 0;
 bool raw_prog::require_guards = false;
 bool raw_prog::require_state_blocks = false;
 bool raw_term::require_fp_step = false;
+size_t raw_progs::threads = 1;
 
 /* Convenience function for getting relation name and arity from
  * term. */
@@ -123,15 +128,22 @@ lexeme input::lex(pccs s) {
 #undef PE
 }
 
-lexemes& input::prog_lex() {
+lexemes& input::prog_lex(ccs end) {
 	lexeme e;
 	error = false;
-	do { if ((e=lex(&data_)) != lexeme{0,0}) l.push_back(e);
-	} while (!error && *(data_));
+	do if ((e=lex(&data_)) != lexeme{0,0}) {
+		if (end && e[0] >= end) break;
+		l.push_back(e);
+	} while (!error && *(data_) && (!end || data_ < end));
 	size_ = (data_ - beg_) * sizeof(ccs);
 	return l;
 }
 
+void input::append_lexed(input& in) {
+	l.insert(l.end(), in.l.begin(), in.l.end());
+	data_ = in.data_, size_ = (data_ - beg_) * sizeof(ccs);
+}
+
 int_t input::get_int_t(ccs from, ccs to) {
 	int_t r = 0;
 	bool neg = false;
@@ -1015,11 +1027,26 @@ bool raw_prog::parse_nested(input* in) {
 }
 
 bool raw_prog::parse(input* in) {
+	vector<fact_chunk> cs;
+	return parse(in, cs);
+}
+
+/* Parses the statements of the input, taking the facts of a chunk parsed ahead
+ * in cs instead when the statements reach its beginning. */
+
+bool raw_prog::parse(input* in, vector<fact_chunk>& cs) {
 	id = ++last_id;
+	auto c = cs.begin();
 	while (in->pos < in->l.size() &&
 			*in->l[in->pos][0] != '}' &&
-			*in->l[in->pos][0] != ']')
-		if (!parse_statement(in)) return --last_id, false;
+			*in->l[in->pos][0] != ']') {
+		while (c != cs.end() && c->beg < in->pos) ++c;
+		if (c != cs.end() && c->beg == in->pos && c->end != c->beg) {
+			for (raw_rule& y : c->facts)
+				y.update_states(has), r.push_back(move(y));
+			in->pos = (c++)->end;
+		} else if (!parse_statement(in)) return --last_id, false;
+	}
 
 	if (macros.empty()) return true;
 
@@ -1093,21 +1120,134 @@ bool raw_prog::macro_expand(input *in, macro mm, const size_t i, const size_t j,
 		false;	
 }
 
+#ifdef WITH_THREADS
+/* Where the data in [b, e) may be split for lexing it in chunks of at least n
+ * bytes: after the newline following a '.' which is not in a comment, string
+ * or character, skipped as input::lex does. */
+
+static vector<ccs> statement_ends(ccs b, ccs e, size_t n) {
+	vector<ccs> r;
+	ccs last = b;
+	for (ccs s = b; s < e && *s; ++s)
+		switch (*s) {
+			case '#':
+				while (s + 1 < e && s[1] && s[1] != '\n' &&
+					s[1] != '\r') ++s;
+				break;
+			case '/':
+				if (s + 1 == e || s[1] != '*') break;
+				for (++s; s + 1 < e && (*s != '*' || s[1] != '/');)
+					++s;
+				++s;
+				break;
+			case '"': case '`':
+				for (const char_t q = *s; ++s < e && *s != q;)
+					if (*s == '\\') ++s;
+				break;
+			case '\'':
+				if (s + 2 >= e) break;
+				if (s[1] == '\'') ++s;
+				else if (s[1] == '\\')
+					s += s[2] == 'x' ? 5 : s[2] == 'u' ? 7 : 3;
+				else s += 1 + (s[1] < 0x80 ? 1 : s[1] < 0xe0 ? 2
+					: s[1] < 0xf0 ? 3 : 4);
+				break;
+			case '.': {
+				ccs t = s + 1;
+				if (t < e && *t == '\r') ++t;
+				if (t < e && *t == '\n' && ++t < e &&
+					(size_t) (t - last) >= n) r.push_back(last = t);
+				break;
+			}
+		}
+	return r;
+}
+
+/* Parses into c the facts which the lexemes of in start with. Only statements
+ * which cannot be anything but facts are tried, as parse_statement tries the
+ * other kinds of statements first. */
+
+static void parse_facts(input& in, const raw_prog& rp, fact_chunk& c) {
+	static const char* keywords[] = { "lfp", "gfp", "pfp", "if", "while",
+		"predtype", "struct", "__fp__" };
+	const lexemes& l = in.l;
+	size_t& pos = in.pos, chl;
+	for (c.beg = c.end = pos; pos != l.size(); c.end = pos) {
+		if (!is_alpha(l[pos][0], l[pos][1] - l[pos][0], chl) &&
+			*l[pos][0] != '_') break;
+		if (any_of(begin(keywords), end(keywords),
+			[&](const char* w) { return l[pos] == w; })) break;
+		size_t k = pos;
+		while (k != l.size() && !(l[k] == "else") && (*l[k][0] == '(' ||
+			*l[k][0] == ')' || *l[k][0] == '_' ||
+			strchr("\"`'", *l[k][0]) ||
+			is_alnum(l[k][0], l[k][1] - l[k][0], chl))) ++k;
+		if (k == l.size() || *l[k][0] != '.') break;
+		raw_rule y;
+		if (!y.parse(&in, rp) || in.error || pos != k + 1 ||
+			y.type != raw_rule::NONE || y.h.size() != 1 ||
+			!y.b.empty() || y.prft || y.h[0].neg ||
+			y.h[0].extype != raw_term::REL) break;
+		c.facts.push_back(move(y));
+	}
+}
+
+/* Lexes the input in chunks on threads, each of which also parses the facts
+ * its chunk starts with. Nothing is returned if the input is too small to be
+ * split or on errors, which lexing it as a whole then reports. */
+
+static vector<fact_chunk> parse_chunks(input* in, const raw_prog& rp) {
+	static const size_t chunk_min = 1 << 20;
+	const size_t threads = raw_progs::threads;
+	ccs b = in->data(), e = in->begin() + in->size();
+	vector<ccs> cuts = statement_ends(b, e,
+		max(chunk_min, (size_t) (e - b) / (threads * 8)));
+	if (cuts.empty()) return {};
+	cuts.insert(cuts.begin(), b);
+	const size_t n = cuts.size();
+	vector<unique_ptr<input>> ins(n);
+	vector<fact_chunk> cs(n);
+	atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t k; (k = next++) < n;) {
+			ccs end = k + 1 == n ? 0 : cuts[k + 1];
+			ins[k] = make_unique<input>((void*) cuts[k], e - cuts[k]);
+			ins[k]->quiet = true, ins[k]->prog_lex(end);
+			if (!ins[k]->error) parse_facts(*ins[k], rp, cs[k]);
+		}
+	};
+	vector<thread> ts;
+	for (size_t t = 1; t < threads; ++t) ts.emplace_back(work);
+	work();
+	for (thread& t : ts) t.join();
+	for (auto& x : ins) if (x->error) return {};
+	for (size_t k = 0; k != n; ++k)
+		cs[k].beg += in->l.size(), cs[k].end += in->l.size(),
+		in->append_lexed(*ins[k]);
+	return cs;
+}
+#endif
+
 bool raw_progs::parse(input* in) {
 	if (!in->data()) return false;
 	lexemes& l = in->l;
 	size_t& pos = in->pos;
+	raw_prog rp(dict);
+	vector<fact_chunk> cs;
+#ifdef WITH_THREADS
+	if (threads > 1) cs = parse_chunks(in, rp);
+	if (cs.empty())
+#endif
 	in->prog_lex();
 	if (in->error) return false;
-	raw_prog rp(dict);
 	raw_prog::require_guards = false;
 	raw_prog::require_state_blocks = false;
-	if (l.size() && !rp.parse(in)) return in->error?false:
+	if (l.size() && !rp.parse(in, cs)) return in->error?false:
 		in->parse_error(l[pos][0],
 			err_rule_dir_prod_expected, l[pos]);
 
 	// TODO fix as guards needs ROOT_EMPTY
- 	p.nps.push_back(rp);
+ 	p.nps.push_back(move(rp));
 	return true;
 }
 
@@ -1240,6 +1380,7 @@ bool input::type_error(const char* e, lexeme l) {
 }
 bool input::parse_error(ccs offset, const char* err, ccs close_to, ccs ctx) {
 	error = true;
+	if (quiet) return false;
 	ostringstream msg; msg << "Parse error: \"" << err << '"';
 	ccs p = close_to;
 	while (p && *p && *p != '\n') ++p;
@@ -1261,6 +1402,7 @@ bool input::parse_error(ccs offset, const char* err, ccs close_to, ccs ctx) {
 
 bool input::type_error(ccs offset, const char* err, ccs close_to) {
 	error = true;
+	if (quiet) return false;
 	ostringstream msg; msg << "Type error: \"" << err << '"';
 	ccs p = close_to;
 	while (p && *p && *p != '\n') ++p;
@@ -43,6 +43,7 @@ struct input {
 	size_t pos = 0;      // position of the currently parsed lexeme
 	lexemes l = {};      // lexemes scanned from the input data
 	bool error = false;  // parse error in the input's data
+	bool quiet = false;  // parse errors are not reported
 	/**
 	 * STDIN input constructor
 	 * @param ns - if true this input would be added as a new sequence ({})
@@ -85,9 +86,16 @@ struct input {
 	lexeme lex(pccs s);
 	/**
 	 * scans input's data for lexemes
+	 * @param end - scans only lexemes starting before end if given
 	 * @return scanned lexemes
 	 */
-	lexemes& prog_lex();
+	lexemes& prog_lex(ccs end = 0);
+	/**
+	 * appends lexemes scanned by an input over the data following the data
+	 * scanned so far, as when the data is scanned in chunks
+	 * @param in - input of the following chunk of the data
+	 */
+	void append_lexed(input& in);
 	/**
 	 * checks if lexeme is in this input and sets l's offset into lr if true
 	 * @param beg - +offset to the resulting range
@@ -798,6 +806,12 @@ struct guard_statement {
 
 struct state_block; 
 
+/* Facts parsed ahead from the lexemes in [beg, end) of an input. */
+struct fact_chunk {
+	size_t beg, end;
+	std::vector<raw_rule> facts;
+};
+
 struct raw_prog {
 	enum ptype {
 		PFP, LFP, GFP
@@ -824,6 +838,7 @@ struct raw_prog {
 	static bool require_state_blocks;
 
 	bool parse(input* in);
+	bool parse(input* in, std::vector<fact_chunk>& cs);
 	bool parse_statement(input* in);
 	bool parse_nested(input* in);
 	bool parse_xfp(input* in);
@@ -836,6 +851,8 @@ struct raw_prog {
 struct raw_progs {
 	std::reference_wrapper<dict_t> dict;
 	raw_prog p;
+	// Threads lexing large inputs and parsing their facts
+	static size_t threads;
 	bool parse(input* in);
 	raw_progs(dict_t &dict_) : dict(dict_), p(dict_) { };
 };
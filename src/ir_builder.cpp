@@ -2059,6 +2059,7 @@ bool ir_builder::transform_grammar(vector<production> g, flat_prog& p) {
 	};
 
 	earley_t parser(g, bltnmap, opts.bin_lr, opts.incr_gen_forest );
+	parser.leo = opts.leo;
 	bool success = parser
 		.recognize(to_u32string(strs.begin()->second));
 	o::inf() << "\n### parser.recognize() : " << (success ? "OK" : "FAIL")<<
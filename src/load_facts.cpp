@@ -0,0 +1,234 @@
+// LICENSE
+// This software is free for use and redistribution while including this
+// license notice, unless:
+// 1. is used for commercial or non-personal purposes, or
+// 2. used for a product which includes or associated with a blockchain or other
+// decentralized database technology, or
+// 3. used for a product which includes or associated with the issuance or use
+// of cryptographic or electronic currencies/coins/tokens.
+// On all of the mentioned cases, an explicit and written permission is required
+// from the Author (Ohad Asor).
+// Contact ohad@idni.org for requesting a permission. This license may be
+// modified over time by the Author.
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include "driver.h"
+#include "err.h"
+using namespace std;
+
+/* Facts are loaded in bulk from a file of records, one per line: separated by
+ * tabs (the default), by commas and quoted as in RFC 4180 (.csv) or triples
+ * of N-Triples (.nt). Fields which are decimal integers become numbers and
+ * all others symbols, interned directly in the dictionary. Records are read
+ * in chunks, each sorted in the order of the bdd variables and built bottom
+ * up into a bdd which is added to the table, so memory stays bounded by the
+ * size of a chunk and the facts never go through raw_prog and flat_prog. */
+
+// Records encoded, sorted and built at once
+static const size_t load_chunk = 1 << 20;
+
+namespace {
+
+struct field {
+	string s;
+	bool num;
+};
+
+/* Reads the records of the text in [p, e) into fields. */
+
+struct record_reader {
+	const char *p, *e;
+	// The separator of fields, or 'n' for N-Triples
+	const char sep;
+	size_t line = 0;
+	record_reader(const char* p, const char* e, char sep) :
+		p(p), e(e), sep(sep) {}
+	// Reads the next record, false at the end of the text or if the
+	// record is malformed, which is told apart by p != e
+	bool next(vector<field>& fs, size_t& n) {
+		for (n = 0; p != e; n = 0) {
+			const char* l = find(p, e, '\n');
+			++line;
+			if (!(sep == 'n' ? triple(l, fs, n) : delimited(l, fs, n)))
+				return false;
+			p = l == e ? e : l + 1;
+			if (n) return true;
+		}
+		return false;
+	}
+private:
+	static bool digits(const string& s) {
+		return !s.empty() && s.size() < 10 && all_of(s.begin(), s.end(),
+			[](char c) { return c >= '0' && c <= '9'; });
+	}
+	static const char* trim(const char* q, const char* l) {
+		return l != q && l[-1] == '\r' ? l - 1 : l;
+	}
+	field& add(vector<field>& fs, size_t& n) {
+		if (fs.size() == n) fs.emplace_back();
+		return fs[n].s.clear(), fs[n].num = false, fs[n++];
+	}
+	// The line ends at l, which moves on if a quoted field spans lines
+	bool delimited(const char*& l, vector<field>& fs, size_t& n) {
+		const char *q = p, *r = trim(q, l);
+		if (q == r) return true;
+		for (;;) {
+			field& f = add(fs, n);
+			if (sep == ',' && q != r && *q == '"') {
+				// "" stands for " within a quoted field
+				for (++q;; ++q)
+					if (q == e) return false;
+					else if (*q != '"') f.s += *q;
+					else if (q + 1 != e && q[1] == '"') f.s += *++q;
+					else break;
+				if (++q > r) l = find(q, e, '\n'), r = trim(q, l);
+				if (q != r && *q != sep) return false;
+			} else {
+				const char* d = find(q, r, sep);
+				f.s.assign(q, d), q = d;
+			}
+			f.num = digits(f.s);
+			if (q == r) return true;
+			++q;
+		}
+	}
+	// An N-Triples term: an IRI, a blank node or a literal whose language
+	// and datatype are dropped, but integers typed as such are numbers
+	bool term(const char*& q, const char* l, field& f) {
+		while (q != l && (*q == ' ' || *q == '\t')) ++q;
+		if (q == l) return false;
+		if (*q == '<') {
+			const char* d = find(q, l, '>');
+			if (d == l) return false;
+			return f.s.assign(q + 1, d), q = d + 1, true;
+		}
+		if (*q == '_') {
+			const char* d = q;
+			while (d != l && *d != ' ' && *d != '\t') ++d;
+			return f.s.assign(q, d), q = d, true;
+		}
+		if (*q != '"') return false;
+		for (++q; q != l && *q != '"'; ++q)
+			if (*q != '\\') f.s += *q;
+			else if (++q == l) return false;
+			else switch (*q) {
+				case 't': f.s += '\t'; break;
+				case 'n': f.s += '\n'; break;
+				case 'r': f.s += '\r'; break;
+				default: f.s += *q;
+			}
+		if (q++ == l) return false;
+		if (q != l && *q == '@')
+			while (q != l && *q != ' ' && *q != '\t') ++q;
+		else if (q != l && *q == '^') {
+			static const char* ints[] = { "integer", "int", "short",
+				"byte", "long", "nonNegativeInteger",
+				"positiveInteger", "unsignedInt", "unsignedShort",
+				"unsignedByte", "unsignedLong" };
+			if (l - q < 3 || q[1] != '^' || q[2] != '<') return false;
+			const char* d = find(q, l, '>');
+			if (d == l) return false;
+			const string dt(q + 3, d);
+			const size_t h = dt.rfind('#');
+			if (h != string::npos && dt.compare(0, h,
+				"http://www.w3.org/2001/XMLSchema") == 0)
+				for (const char* t : ints)
+					if (dt.compare(h + 1, string::npos, t) == 0)
+						f.num = digits(f.s);
+			q = d + 1;
+		}
+		return true;
+	}
+	bool triple(const char*& l, vector<field>& fs, size_t& n) {
+		const char* q = p;
+		while (q != l && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+		if (q == l || *q == '#') return true;
+		for (size_t k = 0; k != 3; ++k)
+			if (!term(q, l, add(fs, n))) return false;
+		while (q != l && (*q == ' ' || *q == '\t')) ++q;
+		if (q == l || *q != '.') return false;
+		for (++q; q != l && (*q == ' ' || *q == '\t' || *q == '\r');)
+			++q;
+		return q == l;
+	}
+};
+
+}
+
+/* Load the facts of a relation from a file, given as REL=FILE. */
+
+bool driver::load_facts(const string& spec) {
+	const size_t eq = spec.find('=');
+	if (eq == string::npos || !eq || eq + 1 == spec.size())
+		return o::err() << err_load_spec << endl, false;
+	const string rel = spec.substr(0, eq), fn = spec.substr(eq + 1);
+	auto ext = [&fn](const char* x) {
+		const size_t n = strlen(x);
+		return fn.size() > n && fn.compare(fn.size() - n, n, x) == 0;
+	};
+	const char sep = ext(".nt") ? 'n' : ext(".csv") ? ',' : '\t';
+	const auto start = chrono::steady_clock::now();
+#ifndef NOMMAP
+	memory_map mm(fn, 0, MMAP_READ);
+	if (mm.error) return o::err() << err_load_read << endl, false;
+	const char *p = (const char*) mm.data(), *e = p + mm.size();
+#else
+	ifstream is(fn, ios::binary);
+	const string buf{ istreambuf_iterator<char>(is),
+		istreambuf_iterator<char>() };
+	if (!is && !is.eof()) return o::err() << err_load_read << endl, false;
+	const char *p = buf.data(), *e = p + buf.size();
+#endif
+	record_reader rr(p, e, sep);
+	vector<field> fs;
+	size_t n, args = 0, records = 0;
+	bool bad = false;
+	ntable tab = -1;
+	ints chunk;
+	vector<const int_t*> sorted;
+	// Sorts the chunk read and adds its facts to the table
+	auto flush = [&]() {
+		if (chunk.empty()) return;
+		ir->syms = dict.nsyms();
+		while (max(max(ir->nums, ir->chars), ir->syms) >=
+			(1 << (tbl->bits - 2))) tbl->add_bit();
+		sorted.clear();
+		for (size_t k = 0; k != chunk.size(); k += args)
+			sorted.push_back(chunk.data() + k);
+		sort(sorted.begin(), sorted.end(),
+			[this, args](const int_t* x, const int_t* y) {
+				return tbl->fact_less(x, y, args); });
+		sorted.erase(unique(sorted.begin(), sorted.end(),
+			[args](const int_t* x, const int_t* y) {
+				return equal(x, x + args, y); }), sorted.end());
+		spbdd_handle x = tbl->from_sorted_facts(sorted, args);
+		table& t = tbl->tbls[tab];
+		t.t = t.t || x, t.edb = t.edb || x, t.prev = hfalse;
+		chunk.clear();
+	};
+	while (rr.next(fs, n)) {
+		if (tab == (ntable) -1)
+			args = n, tab = ir->get_table(ir->get_sig(
+				dict.get_lexeme(rel), { (int_t) args }));
+		else if (n != args) { bad = true; break; }
+		for (size_t k = 0; k != n; ++k)
+			// larger numbers would not fit in an encoded int_t
+			if (int_t v; fs[k].num && (v = stoi(fs[k].s)) < 1 << 29) {
+				ir->nums = max(ir->nums, v);
+				chunk.push_back(mknum(v));
+			} else chunk.push_back(mksym(dict.get_sym(
+				dict.get_lexeme(fs[k].s))));
+		++records;
+		if (chunk.size() >= load_chunk * args) flush();
+	}
+	if (bad || rr.p != e) return o::err() << err_load_format << fn << ':' <<
+		rr.line << endl, false;
+	flush();
+	const double ms = chrono::duration<double, milli>(
+		chrono::steady_clock::now() - start).count();
+	o::ms() << "# load: " << rel << ": " << records << " records in " <<
+		ms << " ms, " << (size_t) (records * 1000 / max(ms, 1e-3)) <<
+		" records/s" << endl;
+	return true;
+}
@@ -29,8 +29,18 @@ int main(int argc, char** argv) {
 	o::init_outputs(oo);
 	options o(argc, argv, &ii, &oo);
 	bdd::init(o.enabled("bdd-mmap") ? MMAP_WRITE : MMAP_NONE,
-		o.get_int("bdd-max-size"), o.get_string("bdd-file"));
+		o.get_int("bdd-max-size"), o.get_string("bdd-file"),
+		o.enabled("bdd-hugepages"));
 	bdd::set_gc_enabled(o.get_bool("gc"));
+	if (auto m = o.get("gc-mode")) bdd::set_gc_mode(m->get_enum(
+		map<string, gc_mode>{ { "compact",  GC_COMPACT },
+				      { "refcount", GC_REFCOUNT } }));
+	bdd::set_ite_cache_size(o.get_int("bdd-cache-size"));
+	bdd::set_reorder_limit(o.get_int("bdd-reorder"));
+#ifdef WITH_THREADS
+	bdd::set_threads(o.get_int("threads"));
+	raw_progs::threads = max(o.get_int("parse-threads"), 1);
+#endif
 	// read from stdin by default if no -i(e), -h, -v and no -repl/udp
 	if (o.disabled("i") && o.disabled("ie")
 #ifdef WITH_THREADS
@@ -50,7 +60,10 @@ int main(int argc, char** argv) {
 		// TODO add iterate or mimnimize output
 		if (o.enabled("dump") && d.result) d.out_result(o::dump());
 		if (o.enabled("dict")) d.out_dict(o::inf());
+		if (o.enabled("info")) d.info(o::inf());
 		if (o.enabled("csv")) d.save_csv();
+		if (o.enabled("save-db")) d.save_db(o.get_string("save-db"));
+		if (o.enabled("profile")) d.save_profile(o.get_string("profile"));
 #ifdef WITH_THREADS
 	}
 #endif
@@ -15,6 +15,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <exception>
+#include <memory>
+#include <new>
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -28,12 +30,15 @@
 #include "output.h"
 
 enum mmap_mode { MMAP_NONE, MMAP_READ, MMAP_WRITE };
+// Hints on how a map is going to be accessed, they can be combined
+enum mmap_advice { MMAP_NORMAL = 0, MMAP_RANDOM = 1, MMAP_HUGE = 2 };
 
 class memory_map {
 public:
 	bool silent = true; // true to disable printing messages to o::err()
 	bool error = false;
 	std::string error_message = "";
+	int advice = MMAP_NORMAL; // mmap_advice applied when mapped
 	memory_map() : mode_(MMAP_NONE),state_(CLOSED),filename_(""),size_(0) {}
 	memory_map(std::string filename, size_t s=0, mmap_mode m = MMAP_READ,
 		bool do_open=1, bool do_map=1)
@@ -101,6 +106,11 @@ public:
 		data_ = ::mmap(0, size_, mode_ == MMAP_READ ? PROT_READ :
 			PROT_READ|PROT_WRITE, MAP_SHARED, fd_, 0);
 		if (data_==MAP_FAILED) return data_=0,err(errno, "mmap err");
+		// hints only, the map works the same if they are not taken
+		if (advice & MMAP_RANDOM) ::madvise(data_, size_, MADV_RANDOM);
+#ifdef MADV_HUGEPAGE
+		if (advice & MMAP_HUGE) ::madvise(data_, size_, MADV_HUGEPAGE);
+#endif
 #endif
 		state_ = MAPPED;
 		return 0;
@@ -227,36 +237,50 @@ private:
 	}
 };
 
+/* Allocates from memory maps of the file fn, or of temporary files if fn is
+ * empty. A container grows by allocating a larger storage before it moves
+ * its elements there and deallocates the old one, so every storage keeps its
+ * own map until it is deallocated. Growing a named file extends it and maps
+ * it again, the old map seeing the same pages while the elements move.
+ * Copies of an allocator share the maps, and it moves along with the storage
+ * of a container assigned to another one. */
+
 template <typename T>
 class memory_map_allocator {
 public:
 	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
 	memory_map_allocator() : fn(""), m(MMAP_NONE) { }
-	memory_map_allocator(std::string fn, mmap_mode m = MMAP_WRITE) :
-		fn(fn), m(m) { }
-	memory_map_allocator(const memory_map_allocator<T>& a) :
-		fn(a.fn), m(a.m) { }
+	memory_map_allocator(std::string fn, mmap_mode m = MMAP_WRITE,
+		int advice = MMAP_NORMAL) : fn(fn), m(m), advice(advice) { }
 	T* allocate(size_t n) {
 		if (m == MMAP_NONE) return (T*) nommap.allocate(n);
 		if (n == 0) return 0;
-		mm = std::make_unique<memory_map>(fn, n*sizeof(T), m);
-		return (T*) mm->data();
+		auto mm = std::make_unique<memory_map>(fn, n*sizeof(T), m, 1, 0);
+		if (mm->advice = advice, mm->error || mm->map() == -1)
+			throw std::bad_alloc();
+		T* p = (T*) mm->data();
+		return maps->push_back(move(mm)), p;
 	}
 	void deallocate(T* p, size_t n) {
 		if (m == MMAP_NONE) return (void) nommap.deallocate(p, n);
 		if (!p || !n) return;
-		mm->close();
+		for (auto it = maps->begin(); it != maps->end(); ++it)
+			if ((*it)->data() == p) return (void) maps->erase(it);
 	}
-	bool operator==(const memory_map_allocator& t) const {                
-		return fn == t.fn && m == t.m && mm == t.mm && nommap==t.nommap;
+	bool operator==(const memory_map_allocator& t) const {
+		return fn == t.fn && m == t.m && maps == t.maps;
 	}
 	bool operator!=(const memory_map_allocator& t) const {
-		return fn != t.fn || m != t.m || mm != t.mm || nommap!=t.nommap;
+		return !(*this == t);
 	}
 private:
 	std::string fn;
 	mmap_mode m;
-	std::unique_ptr<memory_map> mm;
+	int advice = MMAP_NORMAL;
+	std::shared_ptr<std::vector<std::unique_ptr<memory_map>>> maps =
+		std::make_shared<std::vector<std::unique_ptr<memory_map>>>();
 	std::allocator<T> nommap;
 };
 
@@ -176,6 +176,11 @@ void options::setup() {
 		.description("port (udp)"));
 	add_bool("repl",    "run TML in REPL mode");
 	add_output    ("repl-output", "repl output");
+	add(option(option::type::INT, { "threads" }).description(
+		"number of threads running bdd operations (default: 1)"));
+	add(option(option::type::INT, { "parse-threads" }).description(
+		"number of threads lexing large inputs and parsing their facts"
+		" (default: 1)"));
 #endif
 	add_bool("sdt",     "sdt transformation");
 	add_bool("show-hidden", "show the contents of hidden relations");
@@ -189,18 +194,38 @@ void options::setup() {
 		" the original's and minimize it for the given number of steps (default: x=0)"));
 	add_bool("safecheck", "to be DEPRECATED: safety check will be always on");
 	add_bool("gc",      "enable garbage collection");
+	add(option(option::type::ENUM, { "gc-mode" }, { "compact", "refcount" })
+		.description("garbage collection strategy: compact (default)"
+		" or refcount"));
 	add(option(option::type::ENUM, { "proof" }, { "none", "tree", "forest", 
 		"partial-tree", "partial-forest" }).description("control if and"
 		" how proofs are extracted: none (default), tree, forest,"
 		" partial-tree, partial-forest"));
 	add_bool("run",     "run program     (enabled by default)");
 	add_bool("csv",     "save result into CSV files");
+	add(option(option::type::STRING, { "save-db" })
+		.description("save result into a database file"));
+	add(option(option::type::STRING, { "load-db" })
+		.description("load a database file saved by --save-db to run on"));
+	add(option(option::type::STRING, { "load" },
+		[this](const option::value& v) { loads.push_back(v.get_string()); })
+		.description("load facts of REL from a TSV, CSV or N-Triples"
+		" FILE given as REL=FILE, can be repeated"));
+	add(option(option::type::STRING, { "profile" }).description(
+		"save a trace of the steps, rules and alternatives run"));
 
 	add_bool("bdd-mmap","use memory mapping for BDD database");
 	add(option(option::type::INT, { "bdd-max-size" }).description(
-		"Maximum size of a bdd memory map (default: 128 MB)"));
+		"Initial size of a bdd memory map, grown as needed"
+		" (default: 128 MB)"));
 	add(option(option::type::STRING, { "bdd-file" })
 		.description("Memory map file used for BDD database"));
+	add_bool("bdd-hugepages","advise huge pages for the BDD memory map");
+	add(option(option::type::INT, { "bdd-cache-size" }).description(
+		"Size of the bdd ite/and computed table (default: 16 MB)"));
+	add(option(option::type::INT, { "bdd-reorder" }).description(
+		"Reorder bdd variables by sifting when a garbage collection"
+		" leaves at least N nodes (default: 0 = never)"));
 
 	add(option(option::type::INT, { "steps", "s" })
 		.description("run N steps"));
@@ -227,6 +252,14 @@ void options::setup() {
 
 	add_bool2("reg-match", "regex", "applies regular expression matching");
 	add_bool2("fp-step","fp","adds __fp__ fact when reaches a fixed point");
+	add_bool2("semi-naive", "sn",
+		"evaluates rules on the tuples new since the previous step");
+	add_bool2("stratify", "strat",
+		"runs positive programs stratum by stratum, each to its fixpoint");
+	add_bool2("bounded-fronts", "bf",
+		"keeps only O(log n) past steps for loop detection");
+	add_bool2("quantify-early", "qe",
+		"joins body terms one by one, quantifying variables once unused");
 	add(option(option::type::STRING, {"arguments","args","options","opts"},
 		[this](const option::value&) {
 			this->program_arguments = !this->program_arguments;
@@ -257,6 +290,7 @@ void options::setup() {
 	add_bool2("bin-lr", "blr", "on the fly binarization and left "
 					"right optimization for earley items");
 	add_bool2("incr-gen-forest", "igf", "incremental generation of forest");
+	add_bool("leo", "Leo's optimization of right recursion for earley items");
 	add_output    ("dump",        "dump output     (@stdout by default)");
 	add_output_alt("output", "o","standard output (@stdout by default)");
 	add_output    ("error",       "errors          (@stderr by default)");
@@ -300,6 +334,7 @@ void options::init_defaults() {
 	error |= !parse(strings{
 		"--run",
 		"--gc",
+		"--gc-mode",     "compact",
 		"--proof",       "none",
 		"--output",      "@stdout",
 		"--dump",        "@stdout",
@@ -310,9 +345,14 @@ void options::init_defaults() {
 #endif
 		"--optimize",
 		"--bdd-max-size","134217728", // 128 MB
+		"--bdd-cache-size","16777216", // 16 MB
+		"--bdd-reorder", "0",
 		"--safecheck",
+		"--leo",
 #ifdef WITH_THREADS
 		"--repl-output", "@stdout",
+		"--threads",     "1",
+		"--parse-threads", "1",
 		"--udp-addr",    "127.0.0.1",
 		"--udp-port",    "6283"
 #endif
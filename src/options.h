@@ -203,6 +203,8 @@ public:
 	template <typename T> void help(std::basic_ostream<T>&) const;
 	inputs* get_inputs() const { return ii; }
 	std::set<std::string> pu_states = {};
+	// REL=FILE pairs of facts to load
+	std::vector<std::string> loads = {};
 	bool error = false;
 private:
 	template <typename T> friend std::basic_ostream<T>& operator<<(std::basic_ostream<T>&, const options&);
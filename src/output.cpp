@@ -52,7 +52,7 @@ namespace o {
 	ostream_t& inf()  { static auto& x = outputs::to("info");   return x; }
 	ostream_t& dbg()  { static auto& x = outputs::to("debug");  return x; }
 #ifdef WITH_THREADS
-	ostream_t& repl() { static auto& x = outputs::to("repl");   return x; }
+	ostream_t& repl() { static auto& x = outputs::to("repl-output"); return x; }
 #endif
 	ostream_t& dump() { static auto& x = outputs::to("dump"); return x; }
 	ostream_t& ms()   { static auto& x = outputs::to("benchmarks");
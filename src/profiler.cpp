@@ -0,0 +1,148 @@
+// LICENSE
+// This software is free for use and redistribution while including this
+// license notice, unless:
+// 1. is used for commercial or non-personal purposes, or
+// 2. used for a product which includes or associated with a blockchain or other
+// decentralized database technology, or
+// 3. used for a product which includes or associated with the issuance or use
+// of cryptographic or electronic currencies/coins/tokens.
+// On all of the mentioned cases, an explicit and written permission is required
+// from the Author (Ohad Asor).
+// Contact ohad@idni.org for requesting a permission. This license may be
+// modified over time by the Author.
+#include <fstream>
+#include <sstream>
+#include <map>
+#include "profiler.h"
+#include "driver.h"
+#include "err.h"
+using namespace std;
+
+profiler::profiler() : t0(clock::now()) {
+	bdd_gc_hook = [this](clock::time_point t, double pause) {
+		events.push_back({ GC, step, 0, 0, 0, ms(t0, t), pause, 0,
+			{ 0, 0, 0, 0, 0 }, 0, "" });
+	};
+}
+
+profiler::~profiler() { bdd_gc_hook = nullptr; }
+
+/* The index in names of the text of the given rule. */
+
+size_t profiler::name(size_t rule) {
+	if (rules.size() <= rule) rules.resize(rule + 1, SIZE_MAX);
+	if (rules[rule] != SIZE_MAX) return rules[rule];
+	const string s = rule_name ? rule_name(rule) : to_string(rule);
+	auto it = name_ids.emplace(s, names.size()).first;
+	if (it->second == names.size()) names.push_back(s);
+	return rules[rule] = it->second;
+}
+
+/* Record the span started at m. The size and the number of tuples of its
+ * result x, if any, are taken over nvars variables. */
+
+void profiler::end(const mark& m, kind k, size_t rule, size_t alt,
+	spbdd_handle x, bdd_shft nvars)
+{
+	const clock::time_point t = clock::now();
+	const bdd_stats s = bdd_get_stats();
+	events.push_back({ k, step, rule, k == RULE || k == ALT ? name(rule)
+		: 0, alt, ms(t0, m.t), ms(m.t, t),
+		body - m.body, { s.nodes - m.s.nodes,
+		s.cache_hits - m.s.cache_hits, s.cache_misses - m.s.cache_misses,
+		s.memo_hits - m.s.memo_hits, s.memo_misses - m.s.memo_misses },
+		x ? bdd_nodes(x) : 0, x ? bdd_count(x, nvars).to_string() : "" });
+}
+
+static string json_str(const string& s) {
+	ostringstream os;
+	os << '"';
+	for (unsigned char c : s)
+		if (c == '"' || c == '\\') os << '\\' << c;
+		else if (c < 0x20) os << "\\u00" << "0123456789abcdef"[c >> 4]
+			<< "0123456789abcdef"[c & 15];
+		else os << c;
+	return os << '"', os.str();
+}
+
+static ostream& json_stats(ostream& os, const bdd_stats& s) {
+	return os << "\"nodes\": " << s.nodes << ", \"cache_hits\": " <<
+		s.cache_hits << ", \"cache_misses\": " << s.cache_misses <<
+		", \"memo_hits\": " << s.memo_hits << ", \"memo_misses\": " <<
+		s.memo_misses;
+}
+
+/* Write the events in the Chrome trace event format, with times in us, and
+ * the summary under its own key, which trace viewers ignore. Rules and
+ * alternatives are summed by their text over the steps they were evaluated
+ * in, their result being the last one. */
+
+void profiler::write(ostream& os) const {
+	static const char* kinds[] = { "step", "rule", "alt", "gc" };
+	struct total {
+		size_t evals = 0;
+		double ms = 0, body = 0;
+		bdd_stats s{ 0, 0, 0, 0, 0 };
+		size_t size = 0;
+		string sat;
+	};
+	map<pair<size_t, size_t>, total> rules;
+	size_t steps = 0, gcs = 0;
+	double gc_ms = 0, run_ms = 0;
+	os << "{\"traceEvents\": [";
+	for (size_t n = 0; n != events.size(); ++n) {
+		const event& e = events[n];
+		os << (n ? ",\n" : "\n") << "{\"name\": " << json_str(
+			e.k == RULE ? names[e.name]
+			: e.k == ALT ? "alt " + to_string(e.alt) + " of rule " +
+				to_string(e.rule)
+			: kinds[e.k]) << ", \"cat\": \"" << kinds[e.k] <<
+			"\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " <<
+			e.ts * 1000 << ", \"dur\": " << e.dur * 1000 <<
+			", \"args\": {\"step\": " << e.step;
+		if (e.k == RULE || e.k == ALT) os << ", \"rule\": " << e.rule;
+		if (e.k == ALT) os << ", \"alt\": " << e.alt;
+		if (e.k != GC) json_stats(os << ", \"body_ms\": " << e.body
+			<< ", ", e.s);
+		if (!e.sat.empty()) os << ", \"size\": " << e.size <<
+			", \"sat\": " << e.sat;
+		os << "}}";
+		if (e.k == STEP) ++steps, run_ms += e.dur;
+		else if (e.k == GC) ++gcs, gc_ms += e.dur;
+		else {
+			total& t = rules[{ e.name, e.k == ALT ? e.alt + 1 : 0 }];
+			++t.evals, t.ms += e.dur, t.body += e.body,
+			t.s.nodes += e.s.nodes, t.s.cache_hits += e.s.cache_hits,
+			t.s.cache_misses += e.s.cache_misses,
+			t.s.memo_hits += e.s.memo_hits,
+			t.s.memo_misses += e.s.memo_misses,
+			t.size = e.size, t.sat = e.sat;
+		}
+	}
+	os << "\n],\n\"summary\": {\"steps\": " << steps << ", \"ms\": " <<
+		run_ms << ", \"gc\": {\"runs\": " << gcs << ", \"ms\": " <<
+		gc_ms << "}, \"rules\": [";
+	// The totals of a rule come before those of its alternatives
+	for (auto it = rules.begin(); it != rules.end(); ++it) {
+		const total& t = it->second;
+		os << (it == rules.begin() ? "\n" : ",\n") << "{\"rule\": " <<
+			json_str(names[it->first.first]);
+		if (it->first.second)
+			os << ", \"alt\": " << it->first.second - 1;
+		json_stats(os << ", \"evals\": " << t.evals << ", \"ms\": " <<
+			t.ms << ", \"body_ms\": " << t.body << ", ", t.s) <<
+			", \"size\": " << t.size << ", \"sat\": " <<
+			(t.sat.empty() ? "0" : t.sat) << "}";
+	}
+	os << "\n]}}" << endl;
+}
+
+/* Save the profile of the run into the given file. */
+
+bool driver::save_profile(const string& fn) const {
+	if (!tbl || !tbl->prof) return false;
+	ofstream os(fn);
+	tbl->prof->write(os);
+	if (!os) return o::err() << err_profile_write << endl, false;
+	return true;
+}
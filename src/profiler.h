@@ -0,0 +1,76 @@
+// LICENSE
+// This software is free for use and redistribution while including this
+// license notice, unless:
+// 1. is used for commercial or non-personal purposes, or
+// 2. used for a product which includes or associated with a blockchain or other
+// decentralized database technology, or
+// 3. used for a product which includes or associated with the issuance or use
+// of cryptographic or electronic currencies/coins/tokens.
+// On all of the mentioned cases, an explicit and written permission is required
+// from the Author (Ohad Asor).
+// Contact ohad@idni.org for requesting a permission. This license may be
+// modified over time by the Author.
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include "bdd.h"
+
+/* Records the steps of a run, the rules and alternatives evaluated in them and
+ * the garbage collections, with their wall time and the BDD work done during
+ * them. The record is written as a Chrome trace followed by a summary per rule
+ * and alternative, one entry per line so that runs can be diffed. */
+
+class profiler {
+public:
+	typedef std::chrono::steady_clock clock;
+	enum kind { STEP, RULE, ALT, GC };
+	// The start of a span
+	struct mark {
+		clock::time_point t;
+		bdd_stats s;
+		double body;
+	};
+	struct event {
+		kind k;
+		// The rule's index and the index of its text in names
+		size_t step, rule, name, alt;
+		// Start and duration in ms, and the part spent in body queries
+		double ts, dur, body;
+		// The BDD work done during the span
+		bdd_stats s;
+		// Nodes of the result and its number of tuples
+		size_t size;
+		std::string sat;
+	};
+	// The step running and the time spent in body queries so far
+	size_t step = 0;
+	double body = 0;
+	// Gives the text of the rule of the given index
+	std::function<std::string(size_t)> rule_name;
+	profiler();
+	~profiler();
+	mark start() const { return { clock::now(), bdd_get_stats(), body }; }
+	void end(const mark& m, kind k, size_t rule = 0, size_t alt = 0,
+		spbdd_handle x = 0, bdd_shft nvars = 0);
+	static double ms(clock::time_point from, clock::time_point to) {
+		return std::chrono::duration<double, std::milli>(to - from)
+			.count();
+	}
+	// The rules are made again, so their texts may change
+	void clear_rules() { rules.clear(); }
+	void write(std::ostream& os) const;
+private:
+	clock::time_point t0;
+	std::vector<event> events;
+	// The texts of the rules seen and the index in names of each rule
+	std::vector<std::string> names;
+	std::map<std::string, size_t> name_ids;
+	std::vector<size_t> rules;
+	size_t name(size_t rule);
+};
+
+#endif
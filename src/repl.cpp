@@ -103,6 +103,18 @@ void repl::add(basic_ostream<T>& os, string line) {
 template void repl::add(basic_ostream<char>&, string);
 template void repl::add(basic_ostream<wchar_t>&, string);
 
+template <typename T>
+void repl::update(basic_ostream<T>& os, string facts, bool retract) {
+	os<<"# "<<(retract ? "Retracting" : "Adding")<<" facts '"<<facts<<"'"
+		<<endl;
+	if (retract ? d->retract_facts(facts) : d->add_facts(facts)) {
+		fin = true;
+		if (ap) d->out(os);
+	} else if (!d->error && ar) run(os); // anew, from the facts
+}
+template void repl::update(basic_ostream<char>&, string, bool);
+template void repl::update(basic_ostream<wchar_t>&, string, bool);
+
 void repl::dump() {
 	os<<"# Dumping to '"<<o.get_string("dump")<<"'"<<endl;
 	dump(o::dump());
@@ -203,6 +215,8 @@ bool repl::eval_input(basic_ostream<T>& os, string l) {
 	else if  (l == "s")   step(os);
 	else if  (size_t s =   parse_size_t(l, "s")) step(os, s);
 	else if  (size_t s =   parse_size_t(l, "b")) break_on_step(os, s);
+	else if ((f = parse_string(l, "+")).size()) update(os, f, false);
+	else if ((f = parse_string(l, "-")).size()) update(os, f, true);
 	else if  (l == "ps")
 		d->set_print_step(toggle(os, "print steps", ps));
 	else if  (l == "pu")
@@ -244,6 +258,8 @@ void repl::help(basic_ostream<T>& os) const {
 		<< "#\tils     - toggle input line sequencing\n"
 		<< "#\tb       - run and break on fixed point\n"
 		<< "#\tb NUM   - run and break on NUM step\n"
+		<< "#\t+ FACTS - add facts, updating the database\n"
+		<< "#\t- FACTS - retract facts, updating the database\n"
 		<< "#\treparse - reparses the program\n"
 		<< "#\trestart - restarts the program\n"
 		<< "#\treset   - resets repl (clears the entered program)\n"
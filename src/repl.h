@@ -78,6 +78,8 @@ private:
 	template <typename T>
 	void add(std::basic_ostream<T>&, std::string line);
 	template <typename T>
+	void update(std::basic_ostream<T>&, std::string facts, bool retract);
+	template <typename T>
 	void run(std::basic_ostream<T>&, size_t steps=0,size_t break_on_step=0);
 	template <typename T>
 	void step(std::basic_ostream<T>&, size_t steps = 1)   { run(os, steps);}
@@ -14,35 +14,34 @@
 #include "driver.h"
 using namespace std;
 
+/* Save the visible relations of the result into tab separated files named
+ * after them. Rows are decompressed a block at a time into a single term. */
+
 void driver::save_csv() const {
-	// TODO use driver methods
-	
-	/* map<elem, ofstream> files;
-	tbl->out([&files](const raw_term& t) {
-		auto it = files.find(t.e[0]);
-		if (it == files.end()) {
-			std::string fname = to_string(lexeme2str(t.e[0].e))
-				+ ".csv";
-			o::inf() << "Saving " << fname << endl;
-			files.emplace(t.e[0], ofstream(fname));
-			it = files.find(t.e[0]);
-		}
-		std::ostream& os = it->second;
-		//auto elem2str = [](const elem&e) { return lexeme2str(e.e); };
-		if (t.neg) os << '~';
-		for (size_t ar = 0, n = 1; ar != t.arity.size();) {
-			while (t.arity[ar] == -1) ++ar;
-			if (n >= t.e.size()) break;
-			while (t.e[n].type == elem::OPENP) ++n;
-			for (int_t k = 0; k != t.arity[ar];)
-				if ((os<<quote_sym(t.e[n++]),
-					++k!=t.arity[ar])) os<<'\t';
-			while (n<t.e.size() && t.e[n].type == elem::CLOSEP) ++n;
-			++ar;
-			while (ar < t.arity.size() && t.arity[ar] == -2) ++ar;
-			if (ar > 1 && t.arity[ar-1] == -2 &&
-				ar != t.arity.size()) os << '\t';
-		}
-		os << endl;
-	}); */
+	bdd_handles trues, falses, undefineds;
+	if (!tbl || !tbl->compute_fixpoint(trues, falses, undefineds)) return;
+	map<string, ofstream> files;
+	for (ntable n = 0; n < (ntable)trues.size(); n++) {
+		if (!rt_opts.show_hidden && tbl->tbls[n].hidden) continue;
+		term r(false, term::REL, NOP, n, ints(tbl->tbls[n].len, 0), 0);
+		ofstream* os = 0;
+		tbl->decompress_block(trues[n], n, [&files, &os, &r, this](
+			const vector<ints>& cols, size_t rows) {
+			for (size_t k = 0; k != rows; ++k) {
+				for (size_t i = 0; i != r.size(); ++i)
+					r[i] = cols[i][k];
+				raw_term t = ir->to_raw_term(r);
+				if (!os) {
+					string fname = to_string(
+						lexeme2str(t.e[0].e)) + ".csv";
+					auto it = files.find(fname);
+					if (it == files.end()) o::inf() << "Saving "
+						<< fname << endl, it = files.emplace(
+						fname, ofstream(fname)).first;
+					os = &it->second;
+				}
+				*os << to_string(t, "\t") << '\n';
+			}
+		});
+	}
 }
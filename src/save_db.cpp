@@ -0,0 +1,122 @@
+// LICENSE
+// This software is free for use and redistribution while including this
+// license notice, unless:
+// 1. is used for commercial or non-personal purposes, or
+// 2. used for a product which includes or associated with a blockchain or other
+// decentralized database technology, or
+// 3. used for a product which includes or associated with the issuance or use
+// of cryptographic or electronic currencies/coins/tokens.
+// On all of the mentioned cases, an explicit and written permission is required
+// from the Author (Ohad Asor).
+// Contact ohad@idni.org for requesting a permission. This license may be
+// modified over time by the Author.
+#include <fstream>
+#include "driver.h"
+#include "err.h"
+using namespace std;
+
+/* A database image is db_magic and db_version followed by the number of bits
+ * per argument, the largest number and character, the symbols of the
+ * dictionary, the tables with their signatures and finally the image of the
+ * BDDs of their contents. Integers are 64-bit in the byte order of the
+ * machine and strings are prefixed by their length. The image holds only the
+ * nodes reachable from the tables, renumbered, so it is as compact as after a
+ * garbage collection and does not depend on where the nodes were. */
+
+static const char db_magic[] = "TMLDB";
+static const uint64_t db_version = 1;
+
+/* Save the fixpoint reached into a database image. */
+
+bool driver::save_db(const string& fn) const {
+	bdd_handles trues, falses, undefineds;
+	if (!tbl || !tbl->compute_fixpoint(trues, falses, undefineds))
+		return o::err() << err_db_fixpoint << endl, false;
+	ofstream os(fn, ios::binary);
+	auto put = [&os](uint64_t x) { os.write((const char*) &x, sizeof x); };
+	auto put_str = [&os, &put](const lexeme& l) {
+		put(l[1] - l[0]), os.write((const char*) l[0], l[1] - l[0]);
+	};
+	os.write(db_magic, sizeof db_magic), put(db_version);
+	put(tbl->bits), put(ir->nums), put(ir->chars), put(dict.nsyms());
+	for (size_t n = 0; n != dict.nsyms(); ++n)
+		put_str(dict.get_sym_lexeme(n));
+	bdd_handles roots;
+	for (ntable n = 0; n != (ntable)tbl->tbls.size(); ++n)
+		if (!tbl->tbls[n].is_builtin()) roots.push_back(trues[n]);
+	put(roots.size());
+	for (const table& t : tbl->tbls) {
+		if (t.is_builtin()) continue;
+		put_str(dict.get_rel_lexeme(t.s.first)), put(t.len),
+		put(t.hidden), put(t.s.second.size());
+		for (const tml_native_t& a : t.s.second) put(a.type), put(a.bit_w);
+	}
+	bdd_write(os, roots);
+	if (!os) return o::err() << err_db_write << endl, false;
+	return true;
+}
+
+/* Load the tables of a database image, mapped into memory, to run the
+ * program on. Its symbols have to get the same ids as when saved, as they
+ * are encoded in the tables, so it is loaded before any symbol is used. */
+
+bool driver::load_db(const string& fn) {
+#ifndef NOMMAP
+	memory_map mm(fn, 0, MMAP_READ);
+	if (mm.error || !mm.data())
+		return o::err() << err_db_read << endl, false;
+	const char *p = (const char*) mm.data(), *e = p + mm.size();
+#else
+	ifstream is(fn, ios::binary);
+	const string buf{ istreambuf_iterator<char>(is),
+		istreambuf_iterator<char>() };
+	if (!is) return o::err() << err_db_read << endl, false;
+	const char *p = buf.data(), *e = p + buf.size();
+#endif
+	auto get = [&p, e](uint64_t& x) {
+		if ((size_t) (e - p) < sizeof x) return false;
+		return memcpy(&x, p, sizeof x), p += sizeof x, true;
+	};
+	auto get_str = [&p, e, &get](string& s) {
+		uint64_t n;
+		if (!get(n) || n > (uint64_t) (e - p)) return false;
+		return s.assign(p, n), p += n, true;
+	};
+	auto bad = [] { return o::err() << err_db_format << endl, false; };
+	uint64_t v, bits, nums, chars, n;
+	string s;
+	if ((size_t) (e - p) < sizeof db_magic ||
+		memcmp(p, db_magic, sizeof db_magic)) return bad();
+	p += sizeof db_magic;
+	if (!get(v) || v != db_version || !get(bits) || !get(nums) ||
+		!get(chars) || !get(n) || bits < tbl->bits) return bad();
+	for (uint64_t k = 0; k != n; ++k)
+		if (!get_str(s)) return bad();
+		else if (dict.get_sym(dict.get_lexeme(s)) != (int_t) k)
+			return o::err() << err_db_dict << endl, false;
+	vector<ntable> tabs;
+	if (!get(n)) return bad();
+	for (uint64_t len, hidden, nargs, type, bit_w; n--;) {
+		if (!get_str(s) || !get(len) || !get(hidden) || !get(nargs))
+			return bad();
+		sig sg{ dict.get_rel(dict.get_lexeme(s)), {} };
+		for (; nargs--; sg.second.push_back({ (native_type) type,
+			(int_t) bit_w }))
+			if (!get(type) || !get(bit_w)) return bad();
+		tabs.push_back(ir->get_table(sg));
+		table& t = tbl->tbls[tabs.back()];
+		if (t.len != len) return bad();
+		t.hidden = hidden;
+	}
+	bdd_handles roots;
+	if (!bdd_read(p, e, roots) || roots.size() != tabs.size())
+		return bad();
+	tbl->bits = bits;
+	ir->nums = max(ir->nums, (int_t) nums);
+	ir->chars = max(ir->chars, (int_t) chars);
+	for (size_t k = 0; k != tabs.size(); ++k) {
+		table& t = tbl->tbls[tabs[k]];
+		t.t = t.edb = roots[k], t.prev = hfalse;
+	}
+	return true;
+}
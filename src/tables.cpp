@@ -103,18 +103,20 @@ spbdd_handle tables::add_bit(spbdd_handle x, size_t args) {
 	uints perm = perm_init(args * bits);
 	for (size_t n = 0; n != args; ++n)
 		for (size_t k = 0; k != bits; ++k)
-			perm[pos(k, n, args)] = pos(k+1, bits+1, n, args);
+			perm[pos(k, n, args)] = pos(k, bits+1, n, args);
 	bdd_handles v = { x ^ perm };
 	for (size_t n = 0; n != args; ++n)
-		v.push_back(::from_bit(pos(0, bits + 1, n, args), false));
+		v.push_back(::from_bit(pos(bits, bits + 1, n, args), false));
 	return bdd_and_many(move(v));
 }
 
 void tables::add_bit() {
 	spbdd_handle x = hfalse;
 	bdd_handles v;
+	// Deltas against the old encoding are void, so treat all as new
 	for (auto& x : tbls)
-		x.t = add_bit(x.t, x.len);
+		x.t = add_bit(x.t, x.len), x.edb = add_bit(x.edb, x.len),
+		x.prev = hfalse;
 	++bits;
 }
 
@@ -203,11 +205,16 @@ bool tables::get_facts(const flat_prog& m) {
 	// Compute the inverse of pos for the collected facts
 	for (auto& p: invert)
 		inverses[p.first] = _inverse(bits, p.second);
-	// Compute the bdds for the each table
+	// Compute the bdds for the each table, keeping what a loaded database
+	// image already put in them
 	for (auto x: from_facts(add, inverses))
-		tbls[x.first].t = x.second;
+		tbls[x.first].t = tbls[x.first].t || x.second,
+		tbls[x.first].edb = tbls[x.first].edb || x.second,
+		tbls[x.first].prev = hfalse;
 	for (auto x: from_facts(del, inverses))
-		tbls[x.first].t = tbls[x.first].t % x.second;
+		tbls[x.first].t = tbls[x.first].t % x.second,
+		tbls[x.first].edb = tbls[x.first].edb % x.second,
+		tbls[x.first].prev = hfalse;
 	if (opts.optimize)
 		(o::ms() << "# get_facts: "),
 		measure_time_end();
@@ -272,6 +279,31 @@ spbdd_handle tables::from_bit(
 	return from_bit(b, i, a, (*current)->at(i));
 }
 
+/* The first variable on which the given facts differ, or args * bits if they
+ * are equal. Variables go over the bits from the most significant one and
+ * over the arguments within each bit. */
+
+size_t tables::fact_diff(const int_t* x, const int_t* y, size_t args) const {
+	size_t a = args, b = 0;
+	for (size_t n = 0; n != args; ++n)
+		if (const int_t z = x[n] ^ y[n]; z && (a == args ||
+			(size_t) msb((uint_t) z) > b)) a = n, b = msb((uint_t) z);
+	return a == args ? args * bits : (bits - b) * args + a;
+}
+
+/* The bdd of facts sorted by fact_less and unique. */
+
+spbdd_handle tables::from_sorted_facts(const vector<const int_t*>& fs,
+	size_t args) const
+{
+	if (!args) return fs.empty() ? hfalse : htrue;
+	return from_sorted_paths(fs.size(), args * bits,
+		[this, &fs, args](size_t k) {
+			return fact_diff(fs[k], fs[k + 1], args); },
+		[this, &fs, args](size_t k, bdd_shft v) {
+			return fact_bit(fs[k], v, args); });
+}
+
 bool tables::handler_eq(const term& t, const varmap& vm, const size_t vl,
 		spbdd_handle &c) const {
 	DBG(assert(t.size() == 2););
@@ -572,8 +604,13 @@ spbdd_handle tables::addtail(cr_spbdd_handle x, size_t len1, size_t len2) const{
 spbdd_handle tables::body_query(body& b, size_t) {
 	if (b.tlast && b.tlast->b == tbls[b.tab].t->b) return b.rlast;
 	b.tlast = tbls[b.tab].t;
-	return b.rlast = (b.neg ? bdd_and_not_ex_perm : bdd_and_ex_perm)
+	const profiler::clock::time_point t =
+		prof ? profiler::clock::now() : profiler::clock::time_point();
+	b.rlast = (b.neg ? bdd_and_not_ex_perm : bdd_and_ex_perm)
 		(b.q, tbls[b.tab].t, b.ex, b.perm);
+	if (prof) prof->body += profiler::ms(t, profiler::clock::now());
+	if (opts.quantify_early) b.rsize = bdd_nodes(b.rlast);
+	return b.rlast;
 }
 
 auto handle_cmp = [](const spbdd_handle& x, const spbdd_handle& y) {
@@ -633,7 +670,9 @@ spbdd_handle tables::alt_query(alt& a, size_t /*DBG(len)*/) {
 	} else if (opts.bproof == proof_mode::none) {
 		// The case where the conjuncts changed but do not have to produce proof
 		a.last = move(v1);
-		a.rlast = bdd_and_many_ex_perm(a.last, a.ex, a.perm);
+		a.rlast = opts.quantify_early && a.size() > 1 && !a.grnd &&
+			a.bltins.empty() ? alt_planned(a)
+			: bdd_and_many_ex_perm(a.last, a.ex, a.perm);
 	} else {
 		// The case where the conjuncts changed and we will have to produce proof
 		a.last = move(v1);
@@ -645,6 +684,130 @@ spbdd_handle tables::alt_query(alt& a, size_t /*DBG(len)*/) {
 	return a.rlast;
 }
 
+/* Order the joins of the body terms of the given alternative greedily. The
+ * smallest result goes first, then the one letting the most variables be
+ * quantified, sharing the most variables with those joined and smallest, in
+ * this order of preference. A variable is quantified right after the last
+ * join of a body term that may mention it. */
+
+void tables::plan_alt(alt& a) {
+	const size_t nv = a.ex.size();
+	// The variables each body result may mention
+	map<body*, bools> sup;
+	for (body* b : a) {
+		bools& s = sup[b] = bools(nv, false);
+		for (size_t n = 0; n != b->ex.size(); ++n)
+			if (!b->ex[n] && b->perm[n] < nv) s[b->perm[n]] = true;
+	}
+	// How many of the bodies left mention each variable
+	vector<size_t> users(nv, 0);
+	for (body* b : a)
+		for (size_t v = 0; v != nv; ++v) users[v] += sup[b][v];
+	vector<body*> left(a.begin(), a.end());
+	bools joined(nv, false);
+	a.plan.clear(), a.plan_ex.clear(), a.plan_sizes.clear();
+	while (!left.empty()) {
+		size_t best = 0;
+		array<size_t, 3> bs{};
+		for (size_t k = 0; k != left.size(); ++k) {
+			const bools& s = sup[left[k]];
+			array<size_t, 3> c{ 0, 0, SIZE_MAX - left[k]->rsize };
+			if (!a.plan.empty()) for (size_t v = 0; v != nv; ++v)
+				if (s[v]) c[0] += a.ex[v] && users[v] == 1,
+					c[1] += joined[v];
+			if (!k || c > bs) best = k, bs = c;
+		}
+		body* b = left[best];
+		left.erase(left.begin() + best);
+		bools ex(nv, false);
+		for (size_t v = 0; v != nv; ++v) {
+			if (sup[b][v]) joined[v] = true, --users[v];
+			ex[v] = a.ex[v] && !users[v];
+		}
+		a.plan.push_back(b), a.plan_ex.push_back(move(ex)),
+		a.plan_sizes.push_back(b->rsize);
+	}
+}
+
+/* Join the body results of the given alternative in its planned order,
+ * quantifying each variable as soon as no body term left mentions it, which
+ * keeps the intermediate results of wide bodies small. The plan is made again
+ * when some body result grew or shrank by more than half. */
+
+spbdd_handle tables::alt_planned(alt& a) {
+	bool stale = a.plan.size() != a.size();
+	for (size_t n = 0; !stale && n != a.plan.size(); ++n)
+		stale = a.plan[n]->rsize > 2 * a.plan_sizes[n] + 8 ||
+			2 * a.plan[n]->rsize + 8 < a.plan_sizes[n];
+	if (stale) plan_alt(a);
+	spbdd_handle x = a.rng && a.eq;
+	for (size_t n = 0; n + 1 != a.plan.size(); ++n)
+		if (hfalse == (x = bdd_and_ex(x, a.plan[n]->rlast, a.plan_ex[n])))
+			return hfalse;
+	return bdd_and_ex_perm(x, a.plan.back()->rlast, a.ex, a.perm);
+}
+
+spbdd_handle tables::body_delta(body& b) {
+	const spbdd_handle& d = tbls[b.tab].d;
+	if (b.dlast && b.dlast->b == d->b) return b.rdlast;
+	b.dlast = d;
+	return b.rdlast = bdd_and_ex_perm(b.q, d, b.ex, b.perm);
+}
+
+/* Semi-naive counterpart of alt_query. When the tables only grow, the
+ * substitutions found in earlier steps are already in the head tables, so it
+ * suffices to compute those using at least one tuple new since the previous
+ * step: the union over the positive body terms of the delta of that term
+ * joined with the full tables of the others. The alternative is evaluated in
+ * full if asked to, because its rule did not run in the previous step, or if
+ * its builtins and formulas do not allow otherwise. */
+
+spbdd_handle tables::alt_delta(alt& a, size_t len, bool full) {
+	if (!seminaive || a.f || a.grnd || !a.bltins.empty() || a.empty())
+		return alt_query(a, len);
+	// With several changed body terms the deltas would cost as many joins
+	// as there are such terms while a BDD delta is seldom much smaller than
+	// its table, so a single full join is preferred
+	size_t changed = 0;
+	for (const body* b : a) changed += !b->neg && hfalse != tbls[b->tab].d;
+	full |= changed > 1;
+	// Alternatives may be shared among rules, and a full result also
+	// serves as a delta
+	if (a.dstep == nstep && (a.dfull || !full)) return a.rdelta;
+	a.dstep = nstep, a.dfull = full;
+	return a.rdelta = full ? alt_query(a, len) : alt_deltas(a);
+}
+
+/* The union over the positive body terms of the given alternative of the
+ * delta of the table of that term joined with the full tables of the
+ * others. */
+
+spbdd_handle tables::alt_deltas(alt& a) {
+	bdd_handles v(a.size()), r;
+	for (size_t n = 0; n != a.size(); ++n)
+		if (hfalse == (v[n] = body_query(*a[n], a.varslen)))
+			return hfalse;
+	v.push_back(a.rng), v.push_back(a.eq);
+	for (size_t n = 0; n != a.size(); ++n) {
+		if (a[n]->neg || tbls[a[n]->tab].d == hfalse) continue;
+		bdd_handles w = v;
+		if (hfalse == (w[n] = body_delta(*a[n]))) continue;
+		sort(w.begin(), w.end(), handle_cmp);
+		r.push_back(bdd_and_many_ex_perm(move(w), a.ex, a.perm));
+	}
+	return bdd_or_many(move(r));
+}
+
+/* Take the tuples added to each table since the previous step. Tables changed
+ * other than by committing a step have their previous contents reset, so that
+ * all their tuples count as new. */
+
+void tables::get_deltas() {
+	for (table& tbl : tbls)
+		if (tbl.t == tbl.prev) tbl.d = hfalse;
+		else tbl.d = tbl.t % tbl.prev, tbl.prev = tbl.t;
+}
+
 bool table::commit(DBG(size_t /*bits*/)) {
 	if (add.empty() && del.empty()) return false;
 	spbdd_handle x;
@@ -675,15 +838,42 @@ bool tables::print_updates_check() {
 	return false;
 }
 
-char tables::fwd(progress& p) noexcept {
-	for (rule& r : rules) {
+/* Run a step, recording it if profiling. */
+
+char tables::fwd(progress& p, const vector<size_t>* rs) noexcept {
+	if (!prof) return fwd_rules(p, rs);
+	prof->step = nstep;
+	const profiler::mark m = prof->start();
+	const char r = fwd_rules(p, rs);
+	return prof->end(m, profiler::STEP), r;
+}
+
+char tables::fwd_rules(progress& p, const vector<size_t>* rs) noexcept {
+	// Deltas suffice when no rule deletes and per step updates are not shown
+	if (opts.semi_naive) get_deltas(), seminaive = datalog &&
+		opts.bproof == proof_mode::none && !populate_tml_update &&
+		!print_updates;
+	profiler::mark mr, ma;
+	for (size_t k = 0, e = rs ? rs->size() : rules.size(); k != e; ++k) {
+		const size_t i = rs ? (*rs)[k] : k;
+		rule& r = rules[i];
 		bdd_handles v(r.size());
 		spbdd_handle x;
-		for (size_t n = 0; n != r.size(); ++n)
-			v[n] = alt_query(*r[n], r.len);
-		if (v == r.last) { if (datalog) continue; x = r.rlast; }
+		const bool full = r.dstep + 1 != nstep;
+		r.dstep = nstep;
+		if (prof) mr = prof->start();
+		for (size_t n = 0; n != r.size(); ++n) {
+			if (prof) ma = prof->start();
+			v[n] = opts.semi_naive ? alt_delta(*r[n], r.len, full)
+				: alt_query(*r[n], r.len);
+			if (prof) prof->end(ma, profiler::ALT, i, n, v[n],
+				r.len * bits);
+		}
+		const bool same = v == r.last;
+		if (same) x = r.rlast;
 		else r.last = v, x = r.rlast = bdd_or_many(move(v)) && r.eq;
-		if (x == hfalse) continue;
+		if (prof) prof->end(mr, profiler::RULE, i, 0, x, r.len * bits);
+		if ((same && datalog) || x == hfalse) continue;
 		(r.neg ? tbls[r.tab].del : tbls[r.tab].add).push_back(x);
 		if (populate_tml_update || (print_updates && print_updates_check())) 
 			p.notify_update(*this, x, r);
@@ -762,10 +952,154 @@ bool tables::add_fixed_point_fact() {
 	return false;
 }
 
+/* Whether the rules only ever add tuples to the tables and nothing observes
+ * the single steps, so that the fixpoint does not depend on the order in
+ * which the rules run. */
+
+bool tables::is_monotone() const {
+	if (!datalog || opts.bproof != proof_mode::none || opts.fp_step ||
+		print_updates || populate_tml_update) return false;
+	for (const rule& r : rules) {
+		if (tbls[r.tab].is_builtin()) return false;
+		for (const alt* a : r) {
+			if (a->f || a->grnd || !a->bltins.empty()) return false;
+			for (const body* b : *a) if (b->neg) return false;
+		}
+	}
+	return true;
+}
+
+/* Group the rules into strata, the strongly connected components of the graph
+ * of dependencies among tables, lowest first. Returns false if the program is
+ * not monotone, since then running the strata one after another may give
+ * other results than running all rules in lock-step. */
+
+bool tables::get_strata(vector<vector<size_t>>& ss) const {
+	if (!is_monotone()) return false;
+	// The tables of the heads depending on each table
+	vector<set<ntable>> g(tbls.size());
+	for (const rule& r : rules)
+		for (const alt* a : r)
+			for (const body* b : *a) g[b->tab].insert(r.tab);
+	// Tarjan's algorithm, which yields the components heads first
+	const size_t none = -1;
+	vector<size_t> idx(tbls.size(), none), low(tbls.size()),
+		comp(tbls.size(), none);
+	vector<ntable> st;
+	size_t nidx = 0, ncomps = 0;
+	function<void(ntable)> visit = [&](ntable v) {
+		idx[v] = low[v] = nidx++, st.push_back(v);
+		for (ntable w : g[v])
+			if (idx[w] == none) visit(w), low[v] = min(low[v], low[w]);
+			else if (comp[w] == none) low[v] = min(low[v], idx[w]);
+		if (low[v] != idx[v]) return;
+		ntable w;
+		do w = st.back(), st.pop_back(), comp[w] = ncomps; while (w != v);
+		++ncomps;
+	};
+	for (ntable v = 0; v != (ntable)tbls.size(); ++v)
+		if (idx[v] == none) visit(v);
+	ss.assign(ncomps, {});
+	for (size_t n = 0; n != rules.size(); ++n)
+		ss[ncomps - 1 - comp[rules[n].tab]].push_back(n);
+	ss.erase(remove_if(ss.begin(), ss.end(),
+		[](const vector<size_t>& s) { return s.empty(); }), ss.end());
+	return true;
+}
+
+/* Run each stratum to its own fixpoint. After the first step of a stratum only
+ * its rules reading tables of the same stratum run again, as all the others
+ * read tables that do not change anymore. */
+
+bool tables::pfp_strata(const vector<vector<size_t>>& ss, progress& ps) {
+	bdd_handles l = get_front();
+	add_front(l);
+	for (size_t k = 0; k != ss.size(); ++k) {
+		clock_t start{}, end;
+		if (opts.optimize) measure_time_start();
+		set<ntable> tabs;
+		vector<size_t> rec;
+		for (size_t n : ss[k]) tabs.insert(rules[n].tab);
+		for (size_t n : ss[k])
+			if (any_of(rules[n].begin(), rules[n].end(), [&](alt* a) {
+				return any_of(a->begin(), a->end(), [&](body* b) {
+					return tabs.find(b->tab) != tabs.end(); }); }))
+				rec.push_back(n);
+		const nlevel begstep = nstep;
+		for (const vector<size_t>* rs = &ss[k];; rs = &rec) {
+			if (print_steps) o::inf() << "# step: " << nstep << endl;
+			++nstep;
+			const bool changes = fwd(ps, rs);
+			if (halt) return true;
+			if (unsat) return contradiction_detected();
+			if (!changes || rec.empty()) break;
+		}
+		if (opts.optimize)
+			(o::ms() << "# stratum " << k << ": " << nstep - begstep
+				<< " steps, "), measure_time_end();
+	}
+	l = get_front();
+	add_front(l), add_front(l);
+	return true;
+}
+
+/* Keep the given front and return the ordinal of an earlier equal front kept,
+ * or the ordinal of the given one if there is none. Fronts are found by the
+ * hash of their handles, which stay the same as long as the fronts are kept.
+ * When bounded, only the fronts with ordinals that are powers of two and the
+ * last one are kept: once the checkpoint is inside a cycle the cycle is found
+ * within its next period or at the next checkpoint, as in Brent's algorithm,
+ * with O(log n) fronts kept. */
+
+size_t tables::add_front(const bdd_handles& l, bool keep) {
+	static const hash<bdd_handles> hsh;
+	const size_t h = hsh(l), ord = nfronts++;
+	size_t r = ord;
+	for (auto it = front_pos.equal_range(h); it.first != it.second; ++it.first)
+		if (fronts[it.first->second] == l) {
+			r = front_ords[it.first->second];
+			break;
+		}
+	// A repeat ends the run, so the front before it is kept for
+	// compute_fixpoint
+	const size_t last = fronts.size() - 1;
+	if (opts.bounded_fronts && !keep && r == ord && !fronts.empty() &&
+		(front_ords[last] & (front_ords[last] - 1))) {
+		for (auto it = front_pos.equal_range(hsh(fronts[last]));
+			it.first != it.second; ++it.first)
+			if (it.first->second == last) {
+				front_pos.erase(it.first);
+				break;
+			}
+		fronts.pop_back(), front_ords.pop_back();
+	}
+	front_pos.emplace(h, fronts.size());
+	fronts.push_back(l), front_ords.push_back(ord);
+	return r;
+}
+
+void tables::clear_fronts() {
+	fronts.clear(), front_ords.clear(), front_pos.clear(), nfronts = 0;
+}
+
+/* Empty the tables for a program to run anew on them. The rules are made
+ * again when adding the program, and what is cached in alternatives and
+ * bodies only depends on the tables joined. */
+
+void tables::clear_tables() {
+	for (table& tbl : tbls)
+		tbl.t = tbl.d = tbl.prev = tbl.edb = hfalse, tbl.unsat = false,
+		tbl.add.clear(), tbl.del.clear();
+	unsat = halt = false, levels.clear(), clear_fronts();
+}
+
 bool tables::pfp(size_t nsteps, size_t break_on_step, progress& ps) {
 	error = false;
+	vector<vector<size_t>> ss;
+	if (opts.stratify && !nsteps && !break_on_step && get_strata(ss))
+		return pfp_strata(ss, ps);
 	bdd_handles l = get_front();
-	fronts.push_back(l);
+	add_front(l);
 	if (opts.bproof != proof_mode::none) levels.emplace_back(l);
 	for (;;) {
 		if (print_steps) o::inf() << "# step: " << nstep << endl;
@@ -778,19 +1112,104 @@ bool tables::pfp(size_t nsteps, size_t break_on_step, progress& ps) {
 
 		if (!fwd_ret && opts.fp_step && add_fixed_point_fact()) return pfp(0, 0, ps);
 
-		fronts.push_back(l);
+		const size_t ord = nfronts, rep = add_front(l);
 		if (halt) return true;
 		if (unsat) return contradiction_detected();
 		if ((break_on_step && nstep == break_on_step) ||
 			(nsteps && nstep == nsteps)) return false; // no FP yet
-		bool is_repeat = (!fwd_ret) ||
-			(std::find(fronts.begin(), fronts.end() - 1, l) != fronts.end() - 1);
+		bool is_repeat = (!fwd_ret) || rep != ord;
 		if (opts.bproof != proof_mode::none) levels.push_back(move(l));
-		if (is_repeat) return is_infloop() ? infloop_detected() : true;
+		if (!is_repeat) continue;
+		// Only checkpoints of the cycle were kept, so run it once more
+		// to get all of its fronts
+		if (opts.bounded_fronts && fwd_ret && ord - rep > 1) {
+			clear_fronts(), add_front(get_front(), true);
+			for (size_t n = ord - rep; n--;) {
+				++nstep, fwd(ps);
+				if (halt) return true;
+				add_front(get_front(), true);
+			}
+		}
+		return is_infloop() ? infloop_detected() : true;
 	}
 	DBGFAIL;
 }
 
+/* Continue from a fixpoint whose tables were changed to the fixpoint of the
+ * changed tables, by semi-naive steps from the tuples changed, without
+ * stratifying. The tables must not have changed since their previous contents
+ * were kept, other than by adding the tuples to start from. */
+
+bool tables::pfp_update(progress& ps) {
+	const bool sn = opts.semi_naive, st = opts.stratify;
+	opts.semi_naive = true, opts.stratify = false;
+	// Every rule ran in the last step to the fixpoint
+	for (rule& r : rules) r.dstep = nstep;
+	clear_fronts();
+	const bool r = pfp(0, 0, ps);
+	opts.semi_naive = sn, opts.stratify = st;
+	return r;
+}
+
+/* Add the given facts to the tables of a monotone program at its fixpoint and
+ * derive their consequences only. */
+
+bool tables::add_facts(const flat_prog& m, progress& ps) {
+	for (table& tbl : tbls) tbl.prev = tbl.t;
+	for (const auto& r : m) {
+		if (r.size() != 1 || r[0].goal || r[0].neg) continue;
+		const spbdd_handle x = from_fact(r[0]);
+		table& tbl = tbls[r[0].tab];
+		tbl.edb = tbl.edb || x, tbl.t = tbl.t || x;
+	}
+	return pfp_update(ps);
+}
+
+/* Retract the given facts from the tables of a monotone program at its
+ * fixpoint by delete and rederive: first delete every tuple having a
+ * derivation that uses a deleted tuple, then put back those of them still
+ * derivable from the tuples left and continue from these to the fixpoint.
+ * Facts left stay, as do tuples not given as facts, which cannot be
+ * retracted. */
+
+bool tables::retract_facts(const flat_prog& m, progress& ps) {
+	bdd_handles del(tbls.size(), hfalse);
+	for (const auto& r : m)
+		if (r.size() == 1 && !r[0].goal && !r[0].neg)
+			del[r[0].tab] = del[r[0].tab] ||
+				(from_fact(r[0]) && tbls[r[0].tab].edb);
+	for (ntable n = 0; n != (ntable)tbls.size(); ++n)
+		tbls[n].edb = tbls[n].edb % del[n], tbls[n].d = del[n];
+	// Over-delete, joining the tuples deleted last with the tables as they
+	// were before deleting anything
+	for (bool changes = true; changes;) {
+		bdd_handles d(tbls.size(), hfalse);
+		changes = false;
+		for (rule& r : rules) {
+			table& tbl = tbls[r.tab];
+			bdd_handles v;
+			for (alt* a : r) v.push_back(alt_deltas(*a));
+			spbdd_handle x = bdd_or_many(move(v)) && r.eq && tbl.t;
+			if (hfalse == (x = x % del[r.tab] % tbl.edb)) continue;
+			d[r.tab] = d[r.tab] || x, del[r.tab] = del[r.tab] || x,
+			changes = true;
+		}
+		for (ntable n = 0; n != (ntable)tbls.size(); ++n) tbls[n].d = d[n];
+	}
+	for (ntable n = 0; n != (ntable)tbls.size(); ++n)
+		tbls[n].t = tbls[n].prev = tbls[n].t % del[n];
+	// Rederive
+	for (rule& r : rules) {
+		r.last.clear();
+		if (del[r.tab] == hfalse) continue;
+		bdd_handles v;
+		for (alt* a : r) v.push_back(alt_query(*a, r.len));
+		tbls[r.tab].t = tbls[r.tab].t ||
+			(bdd_or_many(move(v)) && r.eq && del[r.tab]);
+	}
+	return pfp_update(ps);
+}
+
 /* Run the given program on the given extensional database and yield
  * the derived facts. Returns true or false depending on whether the
  * given program reaches a fixed point. Useful for query containment
@@ -798,7 +1217,9 @@ bool tables::pfp(size_t nsteps, size_t break_on_step, progress& ps) {
 
 
 
-tables::tables(rt_options opts_, builtins &bltins_) : opts(opts_), bltins(bltins_) {}
+tables::tables(rt_options opts_, builtins &bltins_) : opts(opts_), bltins(bltins_) {
+	if (opts.profile) prof = make_unique<profiler>();
+}
 
 tables::~tables() {
 	while (!bodies.empty()) {
@@ -854,6 +1275,9 @@ bool tables::compute_fixpoint(bdd_handles &trues, bdd_handles &falses, bdd_handl
 		int_t cycle_start;
 		for(cycle_start = fronts_size - 2;
 			fronts[cycle_start] != fronts.back(); cycle_start--);
+		// Fronts in between may be missing if only checkpoints were kept
+		if(front_ords.back() - front_ords[cycle_start] !=
+			(size_t)(fronts_size - 1 - cycle_start)) return false;
 		// Make a buffer to hold the sequence of states a single table
 		// eventually cycles through
 		bdd_handles cycle(fronts_size - 1 - cycle_start);
@@ -879,24 +1303,60 @@ bool tables::compute_fixpoint(bdd_handles &trues, bdd_handles &falses, bdd_handl
 
 void tables::decompress(spbdd_handle x, ntable tab, const cb_decompress& f,
 	size_t len, bool allowbltins) const {
-	table tbl = tbls.at(tab);
+	if (!len) len = tbls.at(tab).len;
+	term r(false, term::REL, NOP, tab, ints(len, 0), 0);
+	decompress_block(x, tab, [&r, &f, len](const vector<ints>& cols,
+		size_t rows) {
+		for (size_t k = 0; k != rows; ++k) {
+			for (size_t n = 0; n != len; ++n) r[n] = cols[n][k];
+			f(r);
+		}
+	}, len, allowbltins);
+}
+
+/* Decompress x into blocks of rows. Each cube of x is expanded by counting
+ * down over its free bits, so that consecutive rows differ in few bits. */
+
+void tables::decompress_block(spbdd_handle x, ntable tab,
+	const cb_decompress_block& f, size_t len, bool allowbltins) const {
+	const table& tbl = tbls.at(tab);
 	if (!allowbltins && tbl.is_builtin()) return; //bltins no decompress
 	if (!len) len = tbl.len;
-	allsat_cb(x, len * bits,
-		[tab, &f, &tbl, len, this](const bools& p, bdd_ref  DBG(y)) {
-		DBG(assert(BDD_ABS(y) == T);)
-		term r(false, term::REL, NOP, tab, ints(len, 0), 0);
-		for (size_t n = 0; n != len; ++n)
+	const size_t block = 1 << 12;
+	vector<ints> cols(len, ints(block));
+	ints r(len), m;
+	vector<size_t> a;
+	size_t rows = 0;
+	allcubes_cb(x, len * bits, [&](const bools& p, const bdd_shfts& dc) {
+		for (size_t n = 0; n != len; ++n) {
+			r[n] = 0;
 			for (size_t k = 0; k != bits; ++k)
-				if (p[pos(k, n, len)])
-					r[n] |= 1 << k;
+				if (p[pos(k, n, len)]) r[n] |= 1 << k;
+		}
+		// Start from all free bits set
+		a.resize(dc.size()), m.resize(dc.size());
+		for (size_t j = 0; j != dc.size(); ++j)
+			a[j] = arg(dc[j], len), m[j] = 1 << bit(dc[j], len),
+			r[a[j]] |= m[j];
+		for (size_t j;;) {
+			for (size_t n = 0; n != len; ++n) cols[n][rows] = r[n];
+			if (++rows == block) f(cols, rows), rows = 0;
+			// Decrement: trailing clear bits get set, the last set
+			// one gets cleared
+			for (j = dc.size(); j && !(r[a[j - 1]] & m[j - 1]); --j)
+				r[a[j - 1]] |= m[j - 1];
+			if (!j) break;
+			r[a[j - 1]] &= ~m[j - 1];
+		}
+	})();
+	if (rows) f(cols, rows);
+}
 
-		#ifdef BIT_TRANSFORM
-		// FIXME Move code to driver/progress monitor
-		#endif
+/* Count the tuples of the table tab. Its arguments are interleaved bit by bit
+ * over the variables 0 to len*bits-1, so a tuple is a model over all of them. */
 
-		f(r);
-	})();
+big_uint tables::cardinality(ntable tab) const {
+	return bdd_count(tbls.at(tab).t, tbls.at(tab).len * bits);
 }
 
 set<term> tables::decompress() {
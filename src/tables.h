@@ -15,6 +15,7 @@
 #define __TABLES_H__
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <tuple>
 #include <functional>
@@ -23,6 +24,7 @@
 #include <emscripten/val.h>
 #endif
 #include "bdd.h"
+#include "profiler.h"
 #include "term.h"
 #include "input.h"
 #include "form.h"
@@ -41,6 +43,10 @@ struct body {
 	bools ex;
 	uints perm;
 	spbdd_handle q, tlast, rlast;
+	// Memo of the query against the table's delta
+	spbdd_handle dlast, rdlast;
+	// Number of nodes of rlast, kept when planning conjunctions
+	size_t rsize = 0;
 	bool operator<(const body& t) const {
 		if (q != t.q) return q < t.q;
 		if (neg != t.neg) return neg;
@@ -60,6 +66,11 @@ struct alt : public std::vector<body*> {
 	// unquantified_last with variables existentially quantified (ex) and permuted
 	// (perm)
 	spbdd_handle rlast = hfalse;
+	// The step of the last semi-naive evaluation, whether it was done in
+	// full and its result
+	size_t dstep = 0;
+	bool dfull = false;
+	spbdd_handle rdelta = hfalse;
 	std::vector<term> t;
 	std::vector<term> bltins; // builtins to run during alt_query
 	bools ex;
@@ -73,6 +84,12 @@ struct alt : public std::vector<body*> {
 	std::set<int_t> bltoutvars; // vars for outputs to compress
 	std::set<std::pair<int_t, body*>> varbodies;
 
+	// The order in which the body terms are joined, the variables to
+	// quantify after each join and the body result sizes planned for
+	std::vector<body*> plan;
+	std::vector<bools> plan_ex;
+	std::vector<size_t> plan_sizes;
+
 	pnft_handle f = 0;
 
 	auto operator<=>(const alt&) const = default;
@@ -84,6 +101,8 @@ struct rule : public std::vector<alt*> {
 	spbdd_handle eq, rlast = hfalse, h;
 	size_t len;
 	bdd_handles last;
+	// The last step this rule was evaluated in
+	size_t dstep = 0;
 	term t;
 
 	auto operator<=>(const rule&) const = default;
@@ -124,6 +143,10 @@ struct table {
 	sig s;
 	size_t len, priority = 0;
 	spbdd_handle t = hfalse;
+	// The tuples new since the previous step and the table at that step
+	spbdd_handle d = hfalse, prev = hfalse;
+	// The tuples given as facts, which stay when retracting other facts
+	spbdd_handle edb = hfalse;
 	bdd_handles add, del;
 	std::vector<size_t> r;
 	bool unsat = false, tmp = false;
@@ -160,6 +183,10 @@ private:
 	typedef std::function<void(size_t,size_t,size_t, const std::vector<term>&)>
 		cb_ground;
 	typedef std::function<void(const term&)> cb_decompress;
+	// Receives decompressed tuples in columns: cols[n][k] is the n-th
+	// argument of the k-th of the given number of rows
+	typedef std::function<void(const std::vector<ints>& cols, size_t rows)>
+		cb_decompress_block;
 
 	std::set<body*, ptrcmp<body>> bodies;
 	std::set<alt*, ptrcmp<alt>> alts;
@@ -208,8 +235,15 @@ public:
 
 private:
 	std::vector<rule> rules;
+	// The fronts of the steps run, or only checkpoints of them if bounded,
+	// with their ordinals, and their positions by fingerprint
 	std::vector<bdd_handles> fronts;
+	std::vector<size_t> front_ords;
+	std::unordered_multimap<size_t, size_t> front_pos;
+	size_t nfronts = 0;
 	std::vector<bdd_handles> levels;
+	// Records the steps run if profiling
+	std::unique_ptr<profiler> prof;
 
 	void get_sym(int_t s, size_t arg, size_t args, spbdd_handle& r) const;
 	void get_var_ex(size_t arg, size_t args, bools& b) const;
@@ -217,6 +251,8 @@ private:
 
 
 	bool datalog, halt = false, unsat = false, bcqc = false;
+	// Whether the current step evaluates alternatives on the deltas only
+	bool seminaive = false;
 
 	size_t pos(size_t bit, size_t nbits, size_t arg, size_t args) const {
 		DBG(assert(bit < nbits && arg < args);)
@@ -285,12 +321,22 @@ private:
 	spbdd_handle addtail(cr_spbdd_handle x, size_t len1, size_t len2) const;
 	spbdd_handle body_query(body& b, size_t);
 	spbdd_handle alt_query(alt& a, size_t);
+	spbdd_handle body_delta(body& b);
+	spbdd_handle alt_delta(alt& a, size_t, bool full);
+	spbdd_handle alt_deltas(alt& a);
+	void plan_alt(alt& a);
+	spbdd_handle alt_planned(alt& a);
+	void get_deltas();
 	DBG(vbools allsat(spbdd_handle x, size_t args) const;)
 public:
 	void decompress(spbdd_handle x, ntable tab, const cb_decompress&,
 		size_t len = 0, bool allowbltins = false) const;
+	void decompress_block(spbdd_handle x, ntable tab,
+		const cb_decompress_block&, size_t len = 0,
+		bool allowbltins = false) const;
 	spbdd_handle from_fact(const term& t);
 	std::set<term> decompress();
+	big_uint cardinality(ntable tab) const;
 
 	static void clear_memos();
 	
@@ -326,6 +372,16 @@ private:
 		const std::pair<std::vector<size_t>, std::vector<size_t>>& inverse) const;
 	spbdd_handle from_bit(const std::vector<const term*>::iterator& current,
 		const std::pair<std::vector<size_t>, std::vector<size_t>>& inverse) const;
+	size_t fact_diff(const int_t* x, const int_t* y, size_t args) const;
+	bool fact_less(const int_t* x, const int_t* y, size_t args) const {
+		const size_t v = fact_diff(x, y, args);
+		return v != args * bits && !fact_bit(x, v, args);
+	}
+	bool fact_bit(const int_t* x, size_t v, size_t args) const {
+		return x[arg(v, args)] & (1 << bit(v, args));
+	}
+	spbdd_handle from_sorted_facts(const std::vector<const int_t*>& fs,
+		size_t args) const;
 
 	void get_alt(const term_set& al, const term& h, std::set<alt>& as,
 		bool blt = false);
@@ -334,7 +390,12 @@ private:
 	bool contradiction_detected();
 	bool infloop_detected();
 
-	char fwd(progress& p) noexcept;
+	char fwd(progress& p, const std::vector<size_t>* rs = 0) noexcept;
+	char fwd_rules(progress& p, const std::vector<size_t>* rs) noexcept;
+	bool is_monotone() const;
+	bool get_strata(std::vector<std::vector<size_t>>& ss) const;
+	bool pfp_strata(const std::vector<std::vector<size_t>>& ss,
+		progress& p);
 	bdd_handles get_front() const;
 	bool bodies_equiv(std::vector<term> x, std::vector<term> y) const;
 	std::set<term> goals;
@@ -429,6 +490,12 @@ public:
 	size_t step() { return nstep; }
 
 	bool pfp(size_t nsteps, size_t break_on_step, progress& p);
+	bool pfp_update(progress& p);
+	bool add_facts(const flat_prog& m, progress& p);
+	bool retract_facts(const flat_prog& m, progress& p);
+	size_t add_front(const bdd_handles& l, bool keep = false);
+	void clear_fronts();
+	void clear_tables();
 	bool compute_fixpoint(bdd_handles &trues, bdd_handles &falses, bdd_handles &undefineds);
 	bool is_infloop();
 	template <typename T>bool get_proof(std::basic_ostream<T>& os);
@@ -15,6 +15,22 @@
 
 using namespace std;
 
+/* Print the tuples of x as facts of the table tab. Rows come in blocks and
+ * share a single term. */
+
+template <typename T>
+void out_facts(basic_ostream<T>& os, tables& tbl, ir_builder& ir,
+	spbdd_handle x, ntable tab) {
+	term r(false, term::REL, NOP, tab, ints(tbl.tbls[tab].len, 0), 0);
+	tbl.decompress_block(x, tab, [&os, &ir, &r](const vector<ints>& cols,
+		size_t rows) {
+		for (size_t k = 0; k != rows; ++k) {
+			for (size_t n = 0; n != r.size(); ++n) r[n] = cols[n][k];
+			os << ir.to_raw_term(r) << ".\n";
+		}
+	});
+}
+
 template <typename T>
 void driver::out_goals(std::basic_ostream<T> &os) {
 	if (tbl->goals.size()) {
@@ -22,12 +38,8 @@ void driver::out_goals(std::basic_ostream<T> &os) {
 		// TODO Change this, fixpoint should be computed before
 		// requesting to output the goals.
 		if(tbl->compute_fixpoint(trues, falses, undefineds)) {
-			for (term t : tbl->goals) {
-				tbl->decompress(trues[t.tab], t.tab, 
-					[&os, this](const term& r) {
-						os << ir->to_raw_term(r) << ".\n"; 
-					});
-			}
+			for (term t : tbl->goals)
+				out_facts(os, *tbl, *ir, trues[t.tab], t.tab);
 		}
 	}
 }
@@ -44,11 +56,8 @@ void driver::out_fixpoint(std::basic_ostream<T> &os) {
 	// requesting to output the fixpoint.
 	if(tbl->compute_fixpoint(trues, falses, undefineds)) {
 		for(ntable n = 0; n < (ntable)trues.size(); n++) {
-			if(rt_opts.show_hidden || !tbl->tbls[n].hidden) {
-				tbl->decompress(trues[n], n, [&os, this](const term& r) {
-					os << ir->to_raw_term(r) << '.' << endl;
-				});
-			}
+			if(rt_opts.show_hidden || !tbl->tbls[n].hidden)
+				out_facts(os, *tbl, *ir, trues[n], n);
 		}
 	}
 }
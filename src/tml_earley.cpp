@@ -53,17 +53,20 @@ bool driver::earley_parse_tml(input* in, raw_progs& rps) {
 			return c < 256 && isspace(c); } },
 		{ U"digit",         [](const char32_t& c)->bool {
 			return c < 256 && isdigit(c); } },
-		{ U"alpha",     [&eof](const char32_t& c)->bool {
+		{ U"alpha",     [eof](const char32_t& c)->bool {
 			return c != eof && (c > 160 || isalpha(c)); } },
-		{ U"alnum",     [&eof](const char32_t& c)->bool {
+		{ U"alnum",     [eof](const char32_t& c)->bool {
 			return c != eof && (c > 160 || isalnum(c)); } },
-		{ U"printable", [&eof](const char32_t& c)->bool {
+		{ U"printable", [eof](const char32_t& c)->bool {
 			return c != eof && (c > 160 || isprint(c)); } },
-		{ U"eof",       [&eof](const char32_t& c)->bool {
+		{ U"eof",       [eof](const char32_t& c)->bool {
 			return c == eof; } }
 	};
-	auto g = load_tml_grammar();
-	earley_t parser(g, bltnmap, opts.enabled("bin-lr"));
+	earley_t*& pp = tml_parser[opts.enabled("bin-lr")];
+	if (!pp) pp = new earley_t(load_tml_grammar(), bltnmap,
+		opts.enabled("bin-lr"));
+	earley_t& parser = *pp;
+	parser.leo = opts.enabled("leo");
 	o::inf() << "\n### parser.recognize() : ";
 	bool success = parser
 		.recognize(to_u32string(string_t(in->data())));
@@ -187,11 +187,11 @@ struct cost {
 		// run program only if there are any rules
 		if (tbls.rules.size()) {
 			tables_progress p( dict, ir);
-			tbls.fronts.clear();
+			tbls.clear_fronts();
 			tbls.pfp(1, 1, p);
 		} else {
 			bdd_handles l = tbls.get_front();
-			tbls.fronts = {l, l};
+			tbls.clear_fronts(), tbls.add_front(l), tbls.add_front(l);
 		}
 
 		end = clock(), t = double(end - start) * 1000000 / CLOCKS_PER_SEC;
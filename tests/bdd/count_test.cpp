@@ -0,0 +1,42 @@
+#include <iostream>
+#include <vector>
+#include "../../src/bdd.h"
+using namespace std;
+
+// Count the satisfying assignments of the given BDD over n variables by
+// enumerating them
+
+size_t brute(const spbdd_handle &x, int n) {
+  size_t r = 0;
+  for(size_t m = 0; m != size_t(1) << n; m++) {
+    spbdd_handle c = htrue;
+    for(int i = 0; i < n; i++) c = c && from_bit(i, m >> i & 1);
+    if((c && x) != hfalse) r++;
+  }
+  return r;
+}
+
+// Test that model counting agrees with enumeration on small functions and
+// stays exact beyond 64 variables
+
+int main() {
+  bdd::init();
+  const int n = 8;
+  vector<spbdd_handle> fs = { hfalse, htrue, from_bit(3, true),
+    from_bit(0, false) || from_eq(2, 5), from_eq(1, 7) % from_bit(4, true),
+    bdd_impl(from_bit(6, true), from_bit(2, false)) && from_eq(0, 3) };
+  for(size_t k = 0; k != fs.size(); k++)
+    if(bdd_count(fs[k], n).get_size() != brute(fs[k], n)) {
+      cout << "Error: Count of function " << k << " is wrong." << endl;
+      return 1;
+    }
+  // Half of 2^100 assignments satisfy a single variable
+  spbdd_handle b = from_bit(70, true);
+  if(bdd_count(b, 100).to_string() != "633825300114114700748351602688" ||
+      bdd_count(b, 100).get_size() != size_t(-1)) {
+    cout << "Error: Count over 100 variables is wrong." << endl;
+    return 1;
+  }
+  cout << "Models of x70 over 100 variables: " << bdd_count(b, 100) << endl;
+  return 0;
+}
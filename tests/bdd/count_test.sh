@@ -0,0 +1,16 @@
+#!/bin/bash
+
+rm -f ./count_test
+ret=0
+
+g++ count_test.cpp \
+	../../build-Release/libTML.a \
+	-W -Wall -Wextra -Wpedantic \
+	-DGIT_DESCRIBED=1 -DGIT_COMMIT_HASH=1 -DGIT_BRANCH=1 \
+	-DWITH_THREADS=TRUE \
+	-std=c++17 -O0 -DDEBUG -ggdb3 -ocount_test -lgcov \
+					&& ./count_test
+
+ret=$?
+rm -f ./count_test
+exit $ret
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+rm -f ./unique_table_bench
+ret=0
+
+g++ unique_table_bench.cpp \
+	../../build-Release/libTML.a \
+	-W -Wall -Wextra -Wpedantic \
+	-DGIT_DESCRIBED=1 -DGIT_COMMIT_HASH=1 -DGIT_BRANCH=1 \
+	-DWITH_THREADS=TRUE \
+	-std=c++17 -O3 -DNDEBUG -ounique_table_bench -lgcov \
+					&& ./unique_table_bench
+
+ret=$?
+rm -f ./unique_table_bench
+exit $ret
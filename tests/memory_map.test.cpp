@@ -131,14 +131,50 @@ test temporary = [] {
 test bdd_mmap_write = [] {
 	std::unique_ptr<bdd_mmap> pM;
 	pM = std::make_unique<bdd_mmap>();
-	pM->emplace_back(0,0,0);
-	pM->emplace_back(1,1,1);
+	pM->emplace_back(0,0);
+	pM->emplace_back(1,1);
 	pM = 0;
 	pM = std::make_unique<bdd_mmap>(
 		memory_map_allocator<bdd>(TF1, MMAP_WRITE));
 	pM->reserve(2);
-	pM->emplace_back(0,0,0);
-	pM->emplace_back(1,1,1);
+	pM->emplace_back(0,0);
+	pM->emplace_back(1,1);
+	return ok();
+};
+
+// grow a vector mapped to a file past several remaps of it
+test vector_with_memory_map_allocator_grow = [] {
+	memory_map_allocator<int_t> a(TF2);
+	vector<int_t, memory_map_allocator<int_t> > v(a);
+	v.reserve(16);
+	for (int_t i = 0; i != 100000; ++i) v.push_back(i-500);
+	for (int_t i = 0; i != 100000; ++i)
+		if (i-500 != v[i]) return fail(
+			"vector_with_memory_map_allocator_grow");
+	return ok();
+};
+
+// grow a vector mapped to temporary files and move it into another one
+test vector_with_memory_map_allocator_grow_and_move = [] {
+	vector<int_t, memory_map_allocator<int_t> > v, w(
+		memory_map_allocator<int_t>("", MMAP_WRITE, MMAP_RANDOM));
+	w.reserve(16);
+	for (int_t i = 0; i != 100000; ++i) w.push_back(i);
+	v = move(w);
+	for (int_t i = 0; i != 100000; ++i) v.push_back(-i);
+	for (int_t i = 0; i != 100000; ++i)
+		if (v[i] != i || v[100000 + i] != -i) return fail(
+			"vector_with_memory_map_allocator_grow_and_move");
+	return ok();
+};
+
+test bdd_mmap_grow = [] {
+	bdd_mmap M(memory_map_allocator<bdd>(TF3, MMAP_WRITE,
+		MMAP_RANDOM | MMAP_HUGE));
+	M.reserve(2);
+	for (bdd_ref i = 0; i != 50000; ++i) M.emplace_back(i, i+1);
+	for (bdd_ref i = 0; i != 50000; ++i)
+		if (!(M[i] == bdd(i, i+1))) return fail("bdd_mmap_grow");
 	return ok();
 };
 
@@ -158,6 +194,9 @@ int main() {
 		mmap_vector_with_nommap_allocator_int_t_write,
 		temporary,
 		bdd_mmap_write,
+		vector_with_memory_map_allocator_grow,
+		vector_with_memory_map_allocator_grow_and_move,
+		bdd_mmap_grow,
 	};
 	return run(tests, "memory_map");
 }
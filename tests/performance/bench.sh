@@ -0,0 +1,122 @@
+#!/bin/bash
+
+# Runs the benchmark corpus with a tml binary and saves the results as JSON.
+# If the results of an earlier run are given as a baseline, they are compared
+# and the script fails if a benchmark got slower by more than the threshold.
+#
+# usage: ./bench.sh <tml> [results.json] [baseline.json] [threshold %]
+#
+# BENCH_REPEAT   runs of each benchmark, the fastest one counts (default: 3)
+# BENCH_FILTER   regular expression selecting the benchmarks to run
+# BENCH_SLACK    slowdowns of up to this many ms always pass (default: 10)
+
+[[ -z "$1" ]] && echo "use the tml binary as the first argument" && exit 1
+tml=$(realpath "$1")
+out=${2:-bench.json}
+baseline=$3
+threshold=${4:-10}
+repeat=${BENCH_REPEAT:-3}
+filter=${BENCH_FILTER:-.}
+slack=${BENCH_SLACK:-10}
+tests=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# transitive closure over circular graphs
+${CXX:-g++} -O2 -o "$work/tcgen" "$tests/tc/tcgen.cpp" || exit 1
+for n in 64 256 1024; do "$work/tcgen" $n > "$work/tc_$n.tml"; done
+
+# a dbpedia like triple store of $1 entities with a class hierarchy
+triples() {
+	awk -v n=$1 'BEGIN {
+		for (c = 2; c <= 64; ++c)
+			printf "triple(c%d subClassOf c%d).\n", c, int(c / 2)
+		for (e = 1; e <= n; ++e) {
+			printf "triple(e%d type c%d).\n", e, e % 63 + 2
+			printf "triple(e%d knows e%d).\n", e, (e * 7) % n + 1
+			printf "triple(e%d label \"entity %d\").\n", e, e
+		}
+		print "subclass(?x ?y) :- triple(?x subClassOf ?y)."
+		print "subclass(?x ?z) :- subclass(?x ?y), subclass(?y ?z)."
+		print "type(?x ?c) :- triple(?x type ?c)."
+		print "type(?x ?d) :- type(?x ?c), subclass(?c ?d)."
+		print "reaches(?x ?y) :- triple(?x knows ?y), type(?y c4)."
+		print "reaches(?x ?z) :- reaches(?x ?y), reaches(?y ?z)."
+	}'
+}
+triples 2000 > "$work/triples_2000.tml"
+
+# a million distinct symbols loaded in bulk, mostly interning them
+awk 'BEGIN { for (k = 0; k != 1000000; ++k) print "s" k }' \
+	> "$work/symbols_1m.tsv"
+echo "n(?x) :- sym(?x), sym(s7)." > "$work/symbols_1m.tml"
+
+corpus=()
+for n in 64 256 1024; do corpus+=("tc_$n:$work/tc_$n.tml"); done
+corpus+=("sieve:$tests/performance/erathos_basic.tml")
+corpus+=("earley_stress_16:$tests/development/earley/stress_16.tml")
+# longer inputs, where the recognizer rather than the forest takes the time
+for n in 128 512 1024; do
+	corpus+=("earley_stress_$n:$tests/development/earley/stress_$n.tml:-bin-lr")
+done
+for f in "$tests"/regression/arith/*.tml; do
+	corpus+=("arith_$(basename "$f" .tml):$f")
+done
+corpus+=("triples_2000:$work/triples_2000.tml")
+corpus+=("symbols_1m:$work/symbols_1m.tml:--load sym=$work/symbols_1m.tsv -dump @null")
+
+# runs benchmark $1 from the file $2, with the options $3 if any, and prints
+# its results as JSON
+bench() {
+	local best="" ms s
+	for ((r = 0; r != repeat; ++r)); do
+		rm -f "$work/info"
+		s=$(date +%s%N)
+		"$tml" -i "$2" $3 -o @null --info "$work/info" \
+			-no-benchmarks -no-debug > /dev/null 2>&1 || return 1
+		ms=$(( ($(date +%s%N) - s) / 1000000 ))
+		[[ -z "$best" || $ms -lt $best ]] && best=$ms
+	done
+	local nodes=$(sed -n 's/.* V: \([0-9]*\) .*/\1/p' "$work/info")
+	local gc=$(sed -n 's/.* pause: \([0-9.e+-]*\) ms.*/\1/p' "$work/info")
+	local rss=$(sed -n 's/.*peak rss: \([0-9]*\) kB.*/\1/p' "$work/info")
+	echo "\"$1\": {\"ms\": $best, \"rss_kb\": ${rss:-0}," \
+		"\"nodes\": ${nodes:-0}, \"gc_ms\": ${gc:-0}}"
+}
+
+status=0
+results=()
+printf "%-24s %10s %10s %10s %10s %10s\n" benchmark ms rss_kb nodes gc_ms \
+	baseline
+for b in "${corpus[@]}"; do
+	name=${b%%:*}
+	[[ "$name" =~ $filter ]] || continue
+	b=${b#*:}
+	if ! r=$(bench "$name" "${b%%:*}" "$(sed -n 's/^[^:]*://p' <<< "$b")")
+	then
+		echo "$name: failed" && status=1 && continue
+	fi
+	results+=("$r")
+	ms=$(sed 's/.*"ms": \([0-9]*\),.*/\1/' <<< "$r")
+	base=""
+	[[ -f "$baseline" ]] && base=$(sed -n \
+		"s/^\"$name\": {\"ms\": \([0-9]*\),.*/\1/p" "$baseline")
+	printf "%-24s %10s %10s %10s %10s %10s" "$name" $ms $(sed \
+		's/.*"rss_kb": \([0-9]*\), "nodes": \([0-9]*\), "gc_ms": \([^}]*\)}/\1 \2 \3/' \
+		<<< "$r") "${base:--}"
+	if [[ -n "$base" ]] && (( ms > base + slack &&
+		ms * 100 > base * (100 + threshold) )); then
+		echo "  slower by more than $threshold%" && status=1
+	else echo; fi
+done
+
+# one benchmark per line, so that results can be diffed and compared
+{
+	echo "{\"repeat\": $repeat, \"benchmarks\": {"
+	for ((k = 0; k != ${#results[@]}; ++k)); do
+		echo "${results[$k]}$( (( k + 1 != ${#results[@]} )) && echo ,)"
+	done
+	echo "}}"
+} > "$out"
+echo "results saved into $out"
+exit $status
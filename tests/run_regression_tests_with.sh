@@ -59,7 +59,7 @@ run() {
 	[[ -n "$diropts" ]] && for opt in ${diropts_arr[*]}; do
 		options+=("$opt")
 	done
-	$tml "${options[@]}"
+	$tml "${options[@]}" $TML_EXTRA
 }
 
 # sort outputs
@@ -0,0 +1,20 @@
+[[ -z "$1" ]] && echo "use number of vertices as the first argument" && exit 1
+threads=${2:-"1 2 4 8 16 32"} # thread counts to measure, can be given as the second argument
+g++ tcgen.cpp # compile a program that outputs a tml program calculating transitive closure over a circular graph with $1 vertices
+./a.out $1 > $1.tml # output the tml program into a file
+mkdir -p build-test && cd build-test
+rm -f CMakeCache.txt
+cmake ../../../src
+make -j4
+cd -
+for t in $threads; do # run tml with each number of threads and report its wall time and the speedup against the first run
+	s=$(date +%s%N)
+	./build-test/tml --threads $t < $1.tml > r
+	e=$(( ($(date +%s%N) - s) / 1000000 ))
+	[[ -z "$base" ]] && base=$e && sort r > r1
+	echo "threads: $t time: $e ms speedup: $(awk "BEGIN { printf \"%.2f\", $base / ($e ? $e : 1) }")"
+	sort r | diff -wq - r1 > /dev/null || echo "threads: $t result differs"
+done
+rm a.out # cleanup
+rm -rf build-test
+rm $1.tml r r1
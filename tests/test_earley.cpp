@@ -121,5 +121,20 @@ int main(int argc, char** argv) {
 	cout << e7.recognize(U"τžluťoučkýτᚠᛇᚻ᛫ᛒᛦᚦ᛫ᚠᚱᚩᚠᚢᚱ᛫ᚠᛁᚱᚪ᛫ᚷᛖᚻᚹᛦᛚᚳᚢᛗτξεσκεπάζωτ") << endl << endl;
 	test_out(c++, e7);
 
+	// right recursion, completed in linear time by Leo's optimization
+	// with the same forest as without it
+	string as(1000, 'a');
+	earley<char> e8({ { "start", { { "a", "start" }, { "a" } } } },
+		binlr, incr_gen);
+	earley<char> e9({ { "start", { { "a", "start" }, { "a" } } } },
+		binlr, incr_gen);
+	e9.leo = false;
+	bool r8 = e8.recognize(as), r9 = e9.recognize(as);
+	cout << r8 << " items: " << e8.count_items() << " without leo: " <<
+		e9.count_items() << endl;
+	if (!r8 || r8 != r9 || 10 * e8.count_items() > e9.count_items() ||
+		e8.get_parse_graph_facts() != e9.get_parse_graph_facts())
+			return cout << "leo failed" << endl, 1;
+
 	return 0;
 }
@@ -0,0 +1,93 @@
+# Generated by CMake
+
+if("${CMAKE_MAJOR_VERSION}.${CMAKE_MINOR_VERSION}" LESS 2.8)
+   message(FATAL_ERROR "CMake >= 2.8.0 required")
+endif()
+if(CMAKE_VERSION VERSION_LESS "2.8.3")
+   message(FATAL_ERROR "CMake >= 2.8.3 required")
+endif()
+cmake_policy(PUSH)
+cmake_policy(VERSION 2.8.3...3.23)
+#----------------------------------------------------------------
+# Generated CMake target import file.
+#----------------------------------------------------------------
+
+# Commands may need to know the format version.
+set(CMAKE_IMPORT_FILE_VERSION 1)
+
+# Protect against multiple inclusion, which would fail when already imported targets are added once more.
+set(_cmake_targets_defined "")
+set(_cmake_targets_not_defined "")
+set(_cmake_expected_targets "")
+foreach(_cmake_expected_target IN ITEMS tml TMLso TMLo)
+  list(APPEND _cmake_expected_targets "${_cmake_expected_target}")
+  if(TARGET "${_cmake_expected_target}")
+    list(APPEND _cmake_targets_defined "${_cmake_expected_target}")
+  else()
+    list(APPEND _cmake_targets_not_defined "${_cmake_expected_target}")
+  endif()
+endforeach()
+unset(_cmake_expected_target)
+if(_cmake_targets_defined STREQUAL _cmake_expected_targets)
+  unset(_cmake_targets_defined)
+  unset(_cmake_targets_not_defined)
+  unset(_cmake_expected_targets)
+  unset(CMAKE_IMPORT_FILE_VERSION)
+  cmake_policy(POP)
+  return()
+endif()
+if(NOT _cmake_targets_defined STREQUAL "")
+  string(REPLACE ";" ", " _cmake_targets_defined_text "${_cmake_targets_defined}")
+  string(REPLACE ";" ", " _cmake_targets_not_defined_text "${_cmake_targets_not_defined}")
+  message(FATAL_ERROR "Some (but not all) targets in this export set were already defined.\nTargets Defined: ${_cmake_targets_defined_text}\nTargets not yet defined: ${_cmake_targets_not_defined_text}\n")
+endif()
+unset(_cmake_targets_defined)
+unset(_cmake_targets_not_defined)
+unset(_cmake_expected_targets)
+
+
+# Create imported target tml
+add_executable(tml IMPORTED)
+
+# Create imported target TMLso
+add_library(TMLso SHARED IMPORTED)
+
+set_target_properties(TMLso PROPERTIES
+  INTERFACE_INCLUDE_DIRECTORIES "/root/repo/src"
+  INTERFACE_LINK_LIBRARIES "TMLo"
+)
+
+# Create imported target TMLo
+add_library(TMLo OBJECT IMPORTED)
+
+set_target_properties(TMLo PROPERTIES
+  INTERFACE_INCLUDE_DIRECTORIES "/root/repo/src;/root/repo/src"
+  INTERFACE_LINK_LIBRARIES "Z3"
+)
+
+# Import target "tml" for configuration "Release"
+set_property(TARGET tml APPEND PROPERTY IMPORTED_CONFIGURATIONS RELEASE)
+set_target_properties(tml PROPERTIES
+  IMPORTED_LOCATION_RELEASE "/root/repo/_gate_build/tml"
+  )
+
+# Import target "TMLso" for configuration "Release"
+set_property(TARGET TMLso APPEND PROPERTY IMPORTED_CONFIGURATIONS RELEASE)
+set_target_properties(TMLso PROPERTIES
+  IMPORTED_LOCATION_RELEASE "/root/repo/_gate_build/libTMLso.so"
+  IMPORTED_SONAME_RELEASE "libTMLso.so"
+  )
+
+# Import target "TMLo" for configuration "Release"
+set_property(TARGET TMLo APPEND PROPERTY IMPORTED_CONFIGURATIONS RELEASE)
+set_target_properties(TMLo PROPERTIES
+  IMPORTED_COMMON_LANGUAGE_RUNTIME_RELEASE ""
+  IMPORTED_OBJECTS_RELEASE "/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/bdd.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/bdd_arith.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/builtins.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/cpp_gen.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/dict.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/driver.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/earley.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/fof.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/form.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/input.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/ir_builder.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/load_facts.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/options.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/output.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/printing.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/profiler.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/proof.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/save_csv.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/save_db.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tables.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tables_progress.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tables_printer.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tables_builtins.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tables_ext.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/tml_earley.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform_guards.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform_opt.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform_opt_cqc.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform_opt_squaring.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/utils.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/iterators.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/typemanager.cpp.o;/root/repo/_gate_build/src/CMakeFiles/TMLo.dir/transform_bitunv.cpp.o"
+  )
+
+# This file does not depend on other imported targets which have
+# been exported from the same project but in a separate export set.
+
+# Commands beyond this point should not need to know the version.
+set(CMAKE_IMPORT_FILE_VERSION)
+cmake_policy(POP)